@@ -0,0 +1,127 @@
+#include <tidypp/document.hpp>
+#include <tidypp/attribute.hpp>
+#include <tidypp/buffer.hpp>
+#include <tidypp/node.hpp>
+#include <tidypp/links.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <list>
+#include <string>
+#include <iostream>
+#include <sstream>
+
+void dumphrefs(tidypp::node &node, std::list<std::string> *dst);
+std::string makepage(int links);
+
+int main(int argc, char *argv[])
+{
+    typedef std::chrono::steady_clock clock;
+
+    int links = argc > 1 ? atoi(argv[1]) : 2000; // number of <a> elements in the test page
+    int rounds = argc > 2 ? atoi(argv[2]) : 200; // how many times each approach is timed
+    std::string page = makepage(links);
+    tidypp::document doc; // tidy html document
+    tidypp::buffer html; // will store our html code
+    tidypp::buffer errbuf; // will store the warnings and errors encountered by html tidy
+    tidypp::linkset set; // reused by extract_links on every round
+    size_t found = 0;
+
+    html.append(const_cast<char *>(page.c_str()), page.length());
+
+    try
+    {
+        doc.seterrorbuffer(errbuf); // assign error buffer
+        doc.optsetbool(TidyForceOutput, true); // output document even if errors were found
+        doc.parsebuffer(html); // parse the html in our buffer
+    }
+    catch (const tidypp::exception &e) // catch exceptions and print the error on screen
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    // the approach of the extract_links example: recursive walk, one std::string per link
+    clock::time_point start = clock::now();
+
+    for (int i = 0; i < rounds; i++)
+    {
+        std::list<std::string> list;
+        tidypp::node root = doc.root();
+
+        dumphrefs(root, &list);
+        found = list.size();
+    }
+
+    double recursive = std::chrono::duration<double, std::milli>(clock::now() - start).count() / rounds;
+
+    std::cout << "dumphrefs:     " << recursive << " ms/page, " << found << " links" << std::endl;
+
+    // the library version: single stackless walk, interned urls, no allocations after the first round
+    start = clock::now();
+
+    for (int i = 0; i < rounds; i++)
+    {
+        tidypp::extract_links(doc, set);
+        found = set.links().size();
+    }
+
+    double library = std::chrono::duration<double, std::milli>(clock::now() - start).count() / rounds;
+
+    std::cout << "extract_links: " << library << " ms/page, " << found << " links, "
+              << set.urlcount() << " distinct" << std::endl;
+    std::cout << "speedup:       " << recursive / library << "x" << std::endl;
+
+    return 0;
+}
+
+/**
+ * Dumps all the links in the document into an std::list<std::string>
+ * by walking the document tree of a tidy html document.
+ * Same as in the extract_links example.
+ *
+ * @param[in] node the root node of the document.
+ * @param[out] dst the destination array of strings.
+ */
+void dumphrefs(tidypp::node &node, std::list<std::string> *dst)
+{
+    for (tidypp::node child = node.child(); child.valid(); child = child.next())
+    {
+        if (child.id() == TidyTag_A)
+        {
+            tidypp::attribute href = child.attrgetbyid(TidyAttr_HREF);
+            ctmbstr hrefval = href.value();
+
+            if (hrefval)
+                dst->push_back(std::string(hrefval));
+        }
+
+        dumphrefs(child, dst);
+    }
+}
+
+/**
+ * Builds a test page with nested sections and the given number of links,
+ * about one in four of them pointing to the same few urls.
+ *
+ * @param links the number of links.
+ * @return the html code.
+ */
+std::string makepage(int links)
+{
+    std::ostringstream oss;
+
+    oss << "<!DOCTYPE html>\n<html>\n<head><title>bench</title></head>\n<body>\n";
+
+    for (int i = 0; i < links; i++)
+    {
+        if (i % 50 == 0)
+            oss << (i ? "</ul></div>\n" : "") << "<div class=\"section\"><ul>\n";
+
+        oss << "<li><p><a href=\"http://example.com/page/" << (i % 4 ? i : i % 16) << "\">link " << i
+            << "</a></p></li>\n";
+    }
+
+    oss << (links ? "</ul></div>\n" : "") << "</body>\n</html>\n";
+
+    return oss.str();
+}
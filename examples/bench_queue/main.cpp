@@ -0,0 +1,167 @@
+#include <tidypp/buffer.hpp>
+#include <tidypp/ringqueue.hpp>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef std::unique_ptr<tidypp::buffer> handle; // move-only, like the documents and buffers of a pipeline
+
+/**
+ * The usual bounded queue: a mutex and two condition variables.
+ */
+class lockedqueue
+{
+public:
+    lockedqueue(size_t capacity)
+        : capacity(capacity)
+    {
+        // empty
+    }
+
+    void push(handle &&h)
+    {
+        std::unique_lock<std::mutex> guard(lock);
+
+        notfull.wait(guard, [this] { return items.size() < capacity; });
+        items.push_back(std::move(h));
+        notempty.notify_one();
+    }
+
+    void pop(handle &h)
+    {
+        std::unique_lock<std::mutex> guard(lock);
+
+        notempty.wait(guard, [this] { return !items.empty(); });
+        h = std::move(items.front());
+        items.pop_front();
+        notfull.notify_one();
+    }
+
+private:
+    size_t capacity;
+    std::mutex lock;
+    std::condition_variable notempty;
+    std::condition_variable notfull;
+    std::deque<handle> items;
+};
+
+/**
+ * Pushes the handles from producer threads and pops them on consumer threads, through the given queue.
+ * Every producer pushes its share of the handles and every consumer pops the same amount.
+ *
+ * @param producers number of producer threads.
+ * @param consumers number of consumer threads.
+ * @param handles the handles, moved through the queue and back into place.
+ * @param push pushes the handles in [first, last) of a producer.
+ * @param pop pops count handles into dst.
+ * @return millions of handles per second.
+ */
+template <class Push, class Pop>
+double run(int producers, int consumers, std::vector<handle> &handles, Push push, Pop pop)
+{
+    typedef std::chrono::steady_clock clock;
+
+    size_t total = handles.size() / (producers * consumers) * (producers * consumers); // evenly split
+    std::vector<std::vector<handle> > received(consumers);
+    std::vector<std::thread> threads;
+    clock::time_point start = clock::now();
+
+    for (int i = 0; i < producers; i++)
+        threads.push_back(std::thread([&, i] { push(&handles[total / producers * i], total / producers); }));
+
+    for (int i = 0; i < consumers; i++)
+    {
+        threads.push_back(std::thread([&, i]
+        {
+            received[i].resize(total / consumers);
+            pop(&received[i][0], total / consumers);
+        }));
+    }
+
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+
+    double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+    // put the handles back for the next round
+    for (size_t i = 0, k = 0; i < received.size(); i++)
+    {
+        for (size_t j = 0; j < received[i].size(); j++)
+            handles[k++] = std::move(received[i][j]);
+    }
+
+    return total / seconds / 1e6;
+}
+
+int main(int argc, char *argv[])
+{
+    int producers = argc > 1 ? atoi(argv[1]) : 4; // producer threads
+    int consumers = argc > 2 ? atoi(argv[2]) : 4; // consumer threads
+    size_t count = argc > 3 ? atoi(argv[3]) : 1000000; // handles moved per round
+    size_t capacity = 1024;
+    const size_t group = 32; // elements per bulk operation
+    std::vector<handle> handles;
+
+    for (size_t i = 0; i < count; i++)
+        handles.push_back(handle(new tidypp::buffer));
+
+    std::cout << producers << " producers, " << consumers << " consumers, " << count << " handles" << std::endl;
+
+    lockedqueue locked(capacity);
+
+    std::cout << "mutex + condvar:   " << run(producers, consumers, handles,
+        [&](handle *h, size_t n) { for (size_t i = 0; i < n; i++) locked.push(std::move(h[i])); },
+        [&](handle *h, size_t n) { for (size_t i = 0; i < n; i++) locked.pop(h[i]); })
+        << " M/s" << std::endl;
+
+    tidypp::ringqueue<handle> ring(capacity);
+
+    std::cout << "ringqueue:         " << run(producers, consumers, handles,
+        [&](handle *h, size_t n) { for (size_t i = 0; i < n; i++) ring.push(std::move(h[i])); },
+        [&](handle *h, size_t n) { for (size_t i = 0; i < n; i++) ring.pop(h[i]); })
+        << " M/s" << std::endl;
+
+    std::cout << "ringqueue, bulk " << group << ": " << run(producers, consumers, handles,
+        [&](handle *h, size_t n)
+        {
+            unsigned spins = 0;
+
+            for (size_t done = 0; done < n; )
+            {
+                size_t k = ring.trypushbulk(h + done, std::min(group, n - done));
+
+                if (k)
+                    spins = 0;
+                else
+                    ring.backoff(spins);
+
+                done += k;
+            }
+        },
+        [&](handle *h, size_t n)
+        {
+            unsigned spins = 0;
+
+            for (size_t done = 0; done < n; )
+            {
+                size_t k = ring.trypopbulk(h + done, std::min(group, n - done));
+
+                if (k)
+                    spins = 0;
+                else
+                    ring.backoff(spins);
+
+                done += k;
+            }
+        })
+        << " M/s" << std::endl;
+
+    return 0;
+}
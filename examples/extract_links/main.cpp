@@ -80,6 +80,8 @@ int main(int argc, char *argv[])
 /**
  * Dumps all the links in the document into an std::list<std::string>
  * by walking the document tree of a tidy html document.
+ * For real workloads, tidypp::extract_links() does the same in one pass, without recursion, and also
+ * collects src/action/srcset and honors <base>.
  *
  * @param[in] node the root node of the document.
  * @param[out] dst the destination array of strings.
@@ -89,12 +91,12 @@ void dumphrefs(tidypp::node &node, std::list<std::string> *dst)
     // iterate all children nodes
     for (tidypp::node child = node.child(); child.valid(); child = child.next())
     {
-        tidypp::tagid id = node.id(); // obtain tag id to check if it's a link
+        tidypp::tagid id = child.id(); // obtain tag id to check if it's a link
 
         // if the node is an <a> tag...
         if (id == TidyTag_A)
         {
-            tidypp::attribute href = node.attrgetbyid(TidyAttr_HREF); // get the href attribute
+            tidypp::attribute href = child.attrgetbyid(TidyAttr_HREF); // get the href attribute
             ctmbstr hrefval = href.value(); // get the value of the attribute (string of the actual link)
 
             if (hrefval) // if the link is not empty...
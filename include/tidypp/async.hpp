@@ -0,0 +1,195 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "tidypp.hpp"
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tidypp
+{
+    // forward declarations
+    class document;
+    class buffer;
+
+    /**
+     * Runs tasks somewhere else. Implement it to run the asynchronous operations (or their completions) on an
+     * existing event loop or thread pool.
+     * @see threadpool
+     */
+    class executor
+    {
+    public:
+        typedef std::function<void()> task; /**< A unit of work. */
+
+        /**
+         * Default destructor.
+         */
+        virtual ~executor() throw();
+
+        /**
+         * Queues a task. Must not run it before returning and must be thread-safe.
+         * @param t the task.
+         */
+        virtual void post(task t) = 0;
+    };
+
+    /**
+     * A fixed set of threads that run posted tasks in order. Used as the default executor of the asynchronous
+     * operations, to keep CPU-bound parsing and cleaning off the threads that do I/O.
+     */
+    class threadpool : public executor
+    {
+    public:
+        /**
+         * Default constructor. Starts the threads.
+         * @param threads number of threads, 0 for one per hardware thread.
+         */
+        threadpool(size_t threads = 0);
+
+        /**
+         * Default destructor. Runs the tasks that are still queued, then joins the threads.
+         */
+        virtual ~threadpool() throw();
+
+        virtual void post(task t);
+
+        /**
+         * Number of threads.
+         * @return an unsigned integer.
+         */
+        size_t size() const throw();
+
+    protected:
+        std::vector<std::thread> threads;
+        std::mutex lock;
+        std::condition_variable wake;
+        std::deque<task> tasks;
+        bool stopping;
+
+        void work() throw();
+
+    private:
+        // non-copyable
+        threadpool(const threadpool &);
+        threadpool &operator=(const threadpool &);
+    };
+
+    /**
+     * Gets the executor used when none is given: a threadpool with one thread per hardware thread, created on
+     * first use.
+     * @return the executor.
+     */
+    executor &defaultexecutor();
+
+    /**
+     * Receives the outcome of an asynchronous operation: NULL on success, otherwise the exception it threw
+     * (usually a tidypp::exception), to be rethrown with std::rethrow_exception().
+     */
+    typedef std::function<void(std::exception_ptr)> completion;
+
+    /**
+     * Parses the markup in a buffer on an executor, see document::parsebuffer().<br />
+     * The document and the buffer must not be used, or destroyed, until the operation completes.<br />
+     * Note: the library is built as C++11 and uses dynamic exception specifications, which C++17 and later
+     * removed, so there are no C++20 awaitables. The completion is the hook for a coroutine framework: resume
+     * the awaiting coroutine from it, passing the caller's executor as resume so it continues where it
+     * started.
+     *
+     * Example:
+     * @verbatim
+       tidypp::async_parse(doc, html, [&](std::exception_ptr err)
+       {
+           // [...] on the I/O loop, given as resume
+       }, tidypp::defaultexecutor(), &ioloop);
+     * @endverbatim
+     *
+     * @param doc the document.
+     * @param buf the buffer containing the markup.
+     * @param done called when the parse is over.
+     * @param ex runs the parse.
+     * @param resume optional, runs the completion. If NULL, the completion runs right after the parse on the
+     *        thread that parsed.
+     */
+    void async_parse(document &doc, buffer &buf, completion done, executor &ex = defaultexecutor(),
+                     executor *resume = NULL);
+
+    /**
+     * Same as the async_parse() that takes a completion, but returns a future.
+     *
+     * @param doc the document.
+     * @param buf the buffer containing the markup.
+     * @param ex runs the parse.
+     * @return a future that becomes ready when the parse is over, and rethrows its exception from get().
+     */
+    std::future<void> async_parse(document &doc, buffer &buf, executor &ex = defaultexecutor());
+
+    /**
+     * Cleans and repairs a parsed document on an executor, see document::cleanandrepair().
+     * The document must not be used, or destroyed, until the operation completes.
+     *
+     * @param doc the document.
+     * @param done called when the cleaning is over.
+     * @param ex runs the cleaning.
+     * @param resume optional, runs the completion. If NULL, it runs on the thread that cleaned.
+     * @see async_parse()
+     */
+    void async_clean(document &doc, completion done, executor &ex = defaultexecutor(), executor *resume = NULL);
+
+    /**
+     * Same as the async_clean() that takes a completion, but returns a future.
+     *
+     * @param doc the document.
+     * @param ex runs the cleaning.
+     * @return a future that becomes ready when the cleaning is over.
+     */
+    std::future<void> async_clean(document &doc, executor &ex = defaultexecutor());
+
+    /**
+     * Saves a document to a buffer on an executor, see document::savebuffer().
+     * The document and the buffer must not be used, or destroyed, until the operation completes.
+     *
+     * @param doc the document.
+     * @param buf the buffer that will receive the document.
+     * @param done called when the save is over.
+     * @param ex runs the save.
+     * @param resume optional, runs the completion. If NULL, it runs on the thread that saved.
+     * @see async_parse()
+     */
+    void async_save(document &doc, buffer &buf, completion done, executor &ex = defaultexecutor(),
+                    executor *resume = NULL);
+
+    /**
+     * Same as the async_save() that takes a completion, but returns a future.
+     *
+     * @param doc the document.
+     * @param buf the buffer that will receive the document.
+     * @param ex runs the save.
+     * @return a future that becomes ready when the save is over.
+     */
+    std::future<void> async_save(document &doc, buffer &buf, executor &ex = defaultexecutor());
+}
@@ -32,6 +32,8 @@ namespace tidypp
     {
         friend attribute node::attrfirst() throw();
         friend attribute node::attrgetbyid(attributeid id) throw();
+        friend attribute node::attr(strview name) throw();
+        friend class node::attribute_iterator;
 
     public:
         /**
@@ -62,6 +64,18 @@ namespace tidypp
          */
         ctmbstr value() throw();
 
+        /**
+         * Gets the attribute name along with its length.
+         * @return a view of the name.
+         */
+        strview nameview() throw();
+
+        /**
+         * Gets the attribute value along with its length.
+         * @return a view of the value, empty if the attribute has no value.
+         */
+        strview valueview() throw();
+
         /**
          * Gets the attribute id.
          * @return an attribute id.
@@ -76,4 +90,38 @@ namespace tidypp
          */
         attribute(const TidyAttr &data) throw();
     };
+
+    /**
+     * Forward iterator over the attributes of a node.<br />
+     * The referenced attribute lives inside the iterator, copy it if you need it after incrementing.
+     * @see node::attributes()
+     */
+    class node::attribute_iterator
+    {
+        friend class node;
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef attribute value_type;
+        typedef ptrdiff_t difference_type;
+        typedef attribute *pointer;
+        typedef attribute &reference;
+
+        /**
+         * Default constructor. Creates a past-the-end iterator.
+         */
+        attribute_iterator() throw();
+
+        attribute &operator*() const throw();
+        attribute *operator->() const throw();
+        attribute_iterator &operator++() throw();
+        attribute_iterator operator++(int) throw();
+        bool operator==(const attribute_iterator &other) const throw();
+        bool operator!=(const attribute_iterator &other) const throw();
+
+    protected:
+        mutable attribute cur;
+
+        attribute_iterator(const TidyAttr &first) throw();
+    };
 }
@@ -0,0 +1,279 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "tidypp.hpp"
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tidypp
+{
+    // forward declarations
+    class document;
+    class metrics;
+
+    namespace io
+    {
+        class inputsource;
+    }
+
+    /**
+     * Runs parse, clean and save (or text extraction) over many inputs on a pool of worker threads.<br />
+     * Each worker owns a mem::pool allocator and a document and buffers built on it, all recycled from one
+     * input to the next and kept across calls to run(), so memory is reused instead of going through the
+     * process-wide Tidy allocator. Workers never share documents or buffers.<br />
+     * Items are dealt to per-worker deques, largest first by default; a worker that runs out of items steals
+     * from the others, so one huge page doesn't leave the rest of the batch waiting behind it.<br />
+     * Pages with errors in the markup are still cleaned and, when force-output is set, saved; they end with
+     * result::status 2 rather than as failures.<br /><br />
+     *
+     * Example:
+     * @verbatim
+       tidypp::batch::config cfg;
+       cfg.options.push_back(std::make_pair("force-output", "yes")); // also save pages with errors
+       cfg.output = tidypp::batch::output_save;
+
+       tidypp::batch b(cfg);
+
+       for (const std::string &path : paths)
+           b.add(tidypp::batch::item::file(path));
+
+       const tidypp::batch::summary &s = b.run();
+       std::cout << s.items << " pages, " << s.throughput() / 1048576 << " MB/s" << std::endl;
+
+       for (const tidypp::batch::result &r : b.results())
+           if (!r.ok)
+               std::cerr << r.message << std::endl; // unreadable input, timeout, limits...
+           else if (r.status == 2)
+               std::cerr << r.errors << " errors in the markup" << std::endl;
+     * @endverbatim
+     */
+    class batch
+    {
+    public:
+        /**
+         * What to keep of each document.
+         */
+        enum outputmode
+        {
+            output_none, /**< Only parse (and clean), e.g. to collect diagnostics or when process does the work. */
+            output_save, /**< The saved document, see document::savebuffer(). */
+            output_text /**< The text content, see document::extract_text(). */
+        };
+
+        /**
+         * An input. Use the static factories to create one.
+         */
+        struct item
+        {
+            std::string path; /**< File to read, if not empty. */
+            const void *data; /**< Input in memory, if path is empty. */
+            size_t size; /**< Size of the input in bytes, or an estimate for sources (0 if unknown). */
+            io::inputsource *source; /**< Input source, if path is empty and data is NULL. */
+
+            /**
+             * Reads the input from a file.
+             * @param path the file path.
+             * @return the item.
+             */
+            static item file(const std::string &path);
+
+            /**
+             * Uses input that is already in memory. The memory must stay valid until run() returns.
+             *
+             * @param[in] data the input.
+             * @param size size of the input in bytes.
+             * @return the item.
+             */
+            static item memory(const void *data, size_t size);
+
+            /**
+             * Reads the input from a source. The source must stay valid until run() returns and must not be
+             * shared with other items.
+             *
+             * @param source the source.
+             * @param sizehint expected size in bytes, 0 if unknown.
+             * @return the item.
+             */
+            static item fromsource(io::inputsource &source, size_t sizehint = 0);
+        };
+
+        /**
+         * The outcome of an item.
+         */
+        struct result
+        {
+            /**
+             * false if the input could not be read, a step failed, or the output mode is output_save and the
+             * document has errors but force-output is not set. Errors in the markup alone don't make an item
+             * fail: check status or errors for those.
+             */
+            bool ok;
+            bool timedout; /**< The item was stopped by config::timeout. */
+            int status; /**< 0 (clean), 1 (warnings) or 2 (errors in the markup), -1 if the input could not be read. */
+            uint errors; /**< Errors reported for this item. */
+            uint warnings; /**< Warnings reported for this item. */
+            size_t bytesin; /**< Input size. */
+            size_t bytesout; /**< Output size. */
+            double seconds; /**< Time spent on this item by its worker. */
+            std::string output; /**< The saved document or its text, depending on config::output. */
+            std::string message; /**< The exception message when ok is false. */
+
+            result() throw();
+        };
+
+        /**
+         * Totals of the last run().
+         */
+        struct summary
+        {
+            size_t items; /**< Items processed. */
+            size_t failed; /**< Items with ok == false. */
+            uint64_t bytesin; /**< Input bytes. */
+            uint64_t bytesout; /**< Output bytes. */
+            double seconds; /**< Wall-clock time of the run. */
+            size_t threads; /**< Workers used. */
+            size_t steals; /**< Items taken by a worker from another worker's deque. */
+
+            summary() throw();
+
+            /**
+             * Input bytes processed per second of wall-clock time.
+             * @return the throughput, 0 for an empty run.
+             */
+            double throughput() const throw();
+        };
+
+        /**
+         * Work done on each document, after parsing and cleaning, on the worker thread. Must be thread-safe.
+         * Receives the index of the item, the document and the result, which it can modify.
+         */
+        typedef std::function<void(size_t, document &, result &)> processfunc;
+
+        /**
+         * Settings shared by all the workers.
+         */
+        struct config
+        {
+            size_t threads; /**< Number of workers, 0 for one per hardware thread. */
+            std::string configfile; /**< Tidy configuration file to load, if not empty. */
+            std::vector<std::pair<std::string, std::string> > options; /**< Applied with optparsevalue(). */
+            std::function<void(document &)> setup; /**< Optional, called once on each new worker document. */
+            bool clean; /**< Run cleanandrepair() after parsing. */
+            bool diagnostics; /**< Run rundiagnostics() after cleaning. */
+            outputmode output; /**< What to keep of each document. */
+            processfunc process; /**< Optional, custom work on each document. */
+
+            /**
+             * Start the biggest inputs first, by item::size or, for files, their size on disk. The largest
+             * single document then starts right away instead of after whatever was queued before it.
+             */
+            bool largefirst;
+
+            /**
+             * Time limit for each item in seconds, 0 for none. When it expires the parse stops at the next read
+             * of the input and the item fails with result::timedout set, so a few pathological pages can't hold
+             * a worker for long. See document::parsebuffer(buffer &buf, const deadline &dl).
+             */
+            double timeout;
+
+            /**
+             * Optional, receives the statistics and the allocation peak of every document. Must outlive the run.
+             */
+            metrics *registry;
+
+            /**
+             * Default constructor. One worker per hardware thread, clean, save output, large inputs first.
+             */
+            config() throw();
+        };
+
+        /**
+         * Default constructor.
+         * @param cfg the settings, copied.
+         */
+        batch(const config &cfg);
+
+        /**
+         * Default destructor. Releases the workers.
+         */
+        virtual ~batch() throw();
+
+        /**
+         * Queues an input for the next run().
+         * @param it the input.
+         */
+        void add(const item &it);
+
+        /**
+         * Number of queued inputs.
+         * @return an unsigned integer.
+         */
+        size_t size() const throw();
+
+        /**
+         * Drops the queued inputs and the results.
+         */
+        void clear() throw();
+
+        /**
+         * Processes all the queued inputs and waits for them. Results are stored in the same order as the inputs.
+         * The inputs stay queued, so run() can be called again (e.g. after changing them in place).
+         *
+         * @return the totals of this run.
+         * @throw tidypp::exception if a worker document cannot be configured.
+         */
+        const summary &run() throw(const exception &);
+
+        /**
+         * Gets the results of the last run(), one per input.
+         * @return the results.
+         */
+        const std::vector<result> &results() const throw();
+
+        /**
+         * Gets the totals of the last run().
+         * @return the totals.
+         */
+        const summary &totals() const throw();
+
+    protected:
+        struct worker; /**< Per-thread allocator, document, buffers and deque of items. */
+
+        config cfg;
+        std::vector<item> items;
+        std::vector<result> res;
+        std::vector<worker *> workers;
+        summary sum;
+
+        void schedule(size_t threads);
+        void work(size_t self, size_t threads) throw();
+        void process(worker &w, size_t index) throw();
+        worker *makeworker() throw(const exception &);
+
+    private:
+        // non-copyable
+        batch(const batch &);
+        batch &operator=(const batch &);
+    };
+}
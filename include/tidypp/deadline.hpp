@@ -0,0 +1,155 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "inputsource.hpp"
+#include <atomic>
+#include <chrono>
+
+namespace tidypp
+{
+    /**
+     * A point in time after which work should stop, and a cancellation flag that stops it earlier.<br />
+     * Pass it to the document operations that take one; cancel() may be called from any thread, e.g. by a
+     * watchdog or when the client of a request disconnects. The same deadline can be shared by all the steps of
+     * a page.
+     *
+     * Example:
+     * @verbatim
+       tidypp::deadline dl(0.5); // half a second for this page
+
+       try
+       {
+           doc.parsebuffer(html, dl);
+           doc.cleanandrepair(dl);
+       }
+       catch (const tidypp::timeout &e)
+       {
+           // [...] skip the page
+       }
+     * @endverbatim
+     *
+     * @see document::parsebuffer(buffer &buf, const deadline &dl)
+     */
+    class deadline
+    {
+    public:
+        typedef std::chrono::steady_clock clock; /**< The clock deadlines are measured with. */
+
+        /**
+         * Default constructor. Never expires, only cancel() stops the work: a plain cancellation token.
+         */
+        deadline() throw();
+
+        /**
+         * Expires after the given time from now.
+         * @param seconds the time limit, in seconds.
+         */
+        explicit deadline(double seconds) throw();
+
+        /**
+         * Expires at the given time.
+         * @param at the time.
+         */
+        explicit deadline(clock::time_point at) throw();
+
+        /**
+         * Default destructor.
+         */
+        virtual ~deadline() throw();
+
+        /**
+         * Expires the deadline right away. Thread-safe.
+         */
+        void cancel() throw();
+
+        /**
+         * Checks if cancel() was called.
+         * @return true if cancelled, otherwise false.
+         */
+        bool cancelled() const throw();
+
+        /**
+         * Checks if the deadline is past or was cancelled. Thread-safe.
+         * @return true if the work should stop, otherwise false.
+         */
+        bool expired() const throw();
+
+        /**
+         * Time left.
+         * @return the remaining seconds, 0 if expired, a very large value if there is no time limit.
+         */
+        double remaining() const throw();
+
+    protected:
+        clock::time_point at; /**< clock::time_point::max() for no time limit. */
+        std::atomic<bool> stop;
+
+    private:
+        // non-copyable
+        deadline(const deadline &);
+        deadline &operator=(const deadline &);
+    };
+
+    namespace io
+    {
+        /**
+         * Wraps an input source and reports the end of the input as soon as a deadline expires, which is how a
+         * parse is stopped: Tidy has no other way to be interrupted. The clock is only read every few thousand
+         * bytes, so the wrapper costs little on the hot path of the lexer.
+         * @see document::parsesource(io::inputsource &source, const deadline &dl)
+         */
+        class deadlinesource : public inputsource
+        {
+        public:
+            /**
+             * Default constructor.
+             *
+             * @param inner the source that provides the input. Must outlive this object.
+             * @param dl the deadline. Must outlive this object.
+             */
+            deadlinesource(inputsource &inner, const deadline &dl) throw(const exception &);
+
+            /**
+             * Default destructor.
+             */
+            virtual ~deadlinesource() throw();
+
+            /**
+             * Checks if the input was cut short by the deadline.
+             * @return true if the deadline expired while reading, otherwise false.
+             */
+            bool truncated() const throw();
+
+        protected:
+            static const uint checkinterval = 4096; /**< Bytes read between two checks of the deadline. */
+
+            inputsource &inner;
+            const deadline &dl;
+            uint countdown; /**< Bytes left before the next check. */
+            bool cut;
+
+            static int TIDY_CALL sourcegetbyte(void *srcdata);
+            static void TIDY_CALL sourceungetbyte(void *srcdata, byte bt);
+            static Bool TIDY_CALL sourceeof(void *srcdata);
+        };
+    }
+}
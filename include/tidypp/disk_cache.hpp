@@ -0,0 +1,163 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "result_cache.hpp"
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace tidypp
+{
+    /**
+     * Persistent cache of cleaned documents, meant as the second tier of a result_cache.<br />
+     * Results are stored in two append-only files: <path>.seg holds the cleaned output, <path>.idx holds one
+     * fixed-size record per result with its key, its location in the segment and its diagnostics. On open the
+     * index file is read sequentially to rebuild the lookup table, and the segment is memory-mapped for reads, so
+     * a restarted worker can serve unchanged pages without running Tidy at all.<br />
+     * A torn record at the end of the index (e.g. after a crash) is detected with a checksum and discarded, and
+     * output that didn't make it to the disk intact is detected with its own hash when it is looked up.
+     * Files are in native byte order and are not meant to be shared between machines.<br />
+     * The files belong to a single process at a time: the constructor takes an exclusive lock on them and throws
+     * if another process already holds it. Within the process, one disk_cache can be shared by any number of
+     * threads.<br />
+     * Only available on POSIX systems, the constructor throws elsewhere.<br /><br />
+     *
+     * Example:
+     * @verbatim
+       tidypp::result_cache cache(64 * 1024 * 1024);
+       tidypp::disk_cache disk("/var/cache/crawler/tidy");
+
+       cache.setdiskcache(&disk); // memory misses now fall back to disk before parsing
+       cache.process(doc, html, out);
+     * @endverbatim
+     */
+    class disk_cache
+    {
+    public:
+        /**
+         * Opens or creates a disk cache.
+         *
+         * @param[in] path path of the cache files, without extension.
+         * @throw tidypp::exception an exception that describes the general cause of the error, e.g. the files
+         *        are locked by another process.
+         */
+        disk_cache(const std::string &path) throw(const exception &);
+
+        /**
+         * Default destructor. Unmaps and closes the cache files.
+         */
+        virtual ~disk_cache() throw();
+
+        /**
+         * Looks up a result.
+         *
+         * @param k the key.
+         * @param[out] res receives a copy of the stored result on a hit.
+         * @return true on a hit, otherwise false. A result whose output doesn't match its hash is dropped and
+         *         counts as a miss.
+         */
+        bool find(const result_cache::key &k, result_cache::result &res);
+
+        /**
+         * Appends a result to the cache. If the key is already stored the new result replaces it; the old bytes
+         * stay in the segment until the files are deleted.
+         *
+         * @param k the key.
+         * @param[in] res the result.
+         * @throw tidypp::exception an exception that describes the general cause of the error.
+         */
+        void insert(const result_cache::key &k, const result_cache::result &res) throw(const exception &);
+
+        /**
+         * Flushes both files to disk.
+         */
+        void sync() throw();
+
+        /**
+         * Number of successful lookups so far.
+         * @return an unsigned integer.
+         */
+        uint64_t hits();
+
+        /**
+         * Number of failed lookups so far.
+         * @return an unsigned integer.
+         */
+        uint64_t misses();
+
+        /**
+         * Number of stored results.
+         * @return an unsigned integer.
+         */
+        size_t count();
+
+        /**
+         * Size of the segment file in bytes.
+         * @return an unsigned integer.
+         */
+        uint64_t segmentsize();
+
+    protected:
+        /**
+         * On-disk index record.
+         */
+        struct record
+        {
+            uint64_t content;
+            uint64_t config;
+            uint64_t size;
+            uint64_t offset; /**< Offset of the output in the segment file. */
+            uint64_t length; /**< Length of the output. */
+            int32_t status;
+            uint32_t errors;
+            uint32_t warnings;
+            uint32_t accesswarnings;
+            uint64_t datahash; /**< fasthash() of the output, checked on every hit. */
+            uint64_t check; /**< hashbytes() of all the fields above. */
+        };
+
+        struct keyhash
+        {
+            size_t operator()(const result_cache::key &k) const throw();
+        };
+
+        std::mutex lock;
+        std::unordered_map<result_cache::key, record, keyhash> index;
+        int segfd;
+        int idxfd;
+        uint64_t segend; /**< End of the valid data in the segment. */
+        const byte *map; /**< Read-only mapping of the segment. */
+        uint64_t mapsize;
+        uint64_t nhits;
+        uint64_t nmisses;
+
+        void load() throw(const exception &);
+        bool remap(uint64_t size) throw();
+        void close() throw();
+        static uint64_t checksum(const record &rec) throw();
+
+    private:
+        // non-copyable
+        disk_cache(const disk_cache &);
+        disk_cache &operator=(const disk_cache &);
+    };
+}
@@ -23,12 +23,19 @@
 #include "basic_wrapper.hpp"
 #include "io.hpp"
 #include "mem.hpp"
+#include "tagset.hpp"
+#include <string>
+#include <vector>
 
 namespace tidypp
 {
     // forward declarations
     class option;
     class node;
+    class selector;
+    class visitor;
+    class deadline;
+    struct flattree;
 
     namespace io
     {
@@ -42,6 +49,78 @@ namespace tidypp
     class document : public basic_wrapper<TidyDoc>
     {
     public:
+        /**
+         * Settings for extract_text().
+         */
+        struct textoptions
+        {
+            /**
+             * Collapse every run of whitespace into a single space and drop whitespace at the start and end
+             * of blocks. Content of pre, listing, xmp, plaintext and textarea is always kept as it is.
+             */
+            bool normalize;
+
+            const char *separator; /**< Appended between blocks and for br, NULL for none. */
+            tagset blocks; /**< Elements that start and end a block. */
+            tagset skip; /**< Elements whose content is skipped entirely. */
+
+            /**
+             * Default constructor. Normalizes whitespace, separates tags::blocks with a newline and skips
+             * script and style.
+             */
+            textoptions() throw();
+        };
+
+        /**
+         * Hard limits on the inputs a document accepts, 0 for no limit. Pages that break them are rejected with
+         * a tidypp::limitexceeded exception instead of being processed, so that a deeply nested or attribute
+         * bomb page can't blow up latency or memory.<br />
+         * parsebuffer() checks the size and does a cheap lexical pre-scan of the markup before handing it to
+         * Tidy, parsesource() stops reading past the size limit, and both check the parsed tree exactly, also
+         * when Tidy reports errors in the markup.
+         * @see setlimits()
+         */
+        struct limits
+        {
+            size_t maxbytes; /**< Input size in bytes. */
+            size_t maxdepth; /**< Element nesting depth, html being at depth 1. */
+            size_t maxattributes; /**< Attributes on a single element. */
+            size_t maxattrlength; /**< Length of an attribute value in bytes. */
+
+            /**
+             * Default constructor. No limits.
+             */
+            limits() throw();
+        };
+
+        /**
+         * What the document spent on its last input, see stats().
+         */
+        struct statistics
+        {
+            /**
+             * Time spent in one phase.
+             */
+            struct timing
+            {
+                double wall; /**< Wall-clock seconds. */
+                double cpu; /**< CPU seconds of the calling thread. */
+                uint calls; /**< Number of calls. */
+
+                timing() throw();
+            };
+
+            timing parse; /**< parsebuffer() and parsesource() */
+            timing clean; /**< cleanandrepair() */
+            timing diagnostics; /**< rundiagnostics() */
+            timing save; /**< savefile(), savestdout(), savebuffer(), savestring() and savesink() */
+            size_t bytesin; /**< Bytes of markup read by the last parse. */
+            size_t bytesout; /**< Bytes written by savebuffer(), savestring() and savesink() since the last parse. */
+            size_t nodes; /**< Nodes in the tree, counted when stats() is called. */
+
+            statistics() throw();
+        };
+
         /**
          * Default constructor.
          */
@@ -331,6 +410,19 @@ namespace tidypp
          */
         bool optdiffthansnapshot() throw();
 
+        /**
+         * Hash of every setting that differs from its default value. Two documents configured the same way have the
+         * same fingerprint, so it can be combined with a hash of the input to key cached results.<br />
+         * Options are hashed by name rather than by id, which keeps the value stable across Tidy versions that
+         * renumber the option table. A document with only default settings always returns hashseed.<br />
+         * The value is cached until a setting is changed through this document.
+         *
+         * @return the 64-bit fingerprint of the current configuration.
+         * @see optdiffthandefault()
+         * @see hashbytes()
+         */
+        hashvalue config_fingerprint() throw();
+
         /**
          * Copy configuration settings from another document.
          *
@@ -438,6 +530,29 @@ namespace tidypp
          */
         void parsebuffer(buffer &buf) throw(const exception &);
 
+        /**
+         * Sets the limits checked by parsebuffer() and parsesource().
+         * @param lim the limits, copied.
+         */
+        void setlimits(const limits &lim) throw();
+
+        /**
+         * Gets the limits checked by parsebuffer() and parsesource().
+         * @return the limits.
+         */
+        const limits &getlimits() const throw();
+
+        /**
+         * Gets the time spent in each phase on the current input, and its size. A parse starts over, the other
+         * phases add up until the next parse.<br />
+         * The timings cost two clock reads per phase and a byte counter on sources and sinks. Building the
+         * library with TIDYPP_NO_STATS defined (./configure --disable-stats) compiles them out: only the node
+         * count and the sizes of buffer inputs and outputs are left.
+         *
+         * @return the statistics. Valid until the next call to a document method.
+         */
+        const statistics &stats();
+
         /**
          * Parse markup in given generic input source.
          *
@@ -446,12 +561,47 @@ namespace tidypp
          */
         void parsesource(io::inputsource &source) throw(const exception &);
 
+        /**
+         * Parse markup in a given buffer, giving up when a deadline expires.<br />
+         * The input is read through an io::deadlinesource, which reports the end of the input as soon as the
+         * deadline expires: Tidy then wraps up whatever it has parsed so far, and the document holds that partial
+         * tree.
+         *
+         * @param[in] buf the buffer containing the markup.
+         * @param dl the deadline.
+         * @throw tidypp::timeout if the deadline expired before or during the parse.
+         * @throw tidypp::exception an exception that describes the general cause of the error.
+         */
+        void parsebuffer(buffer &buf, const deadline &dl) throw(const exception &);
+
+        /**
+         * Parse markup in given generic input source, giving up when a deadline expires.
+         *
+         * @param[in] source the input source.
+         * @param dl the deadline.
+         * @throw tidypp::timeout if the deadline expired before or during the parse.
+         * @throw tidypp::exception an exception that describes the general cause of the error.
+         * @see parsebuffer(buffer &buf, const deadline &dl)
+         */
+        void parsesource(io::inputsource &source, const deadline &dl) throw(const exception &);
+
         /**
          * Execute configured cleanup and repair operations on parsed markup.
          * @throw tidypp::exception an exception that describes the general cause of the error.
          */
         void cleanandrepair() throw(const exception &);
 
+        /**
+         * Execute configured cleanup and repair operations on parsed markup, unless a deadline has expired.<br />
+         * Tidy can't be interrupted once cleaning starts, so the deadline is only checked before: bound the time
+         * spent on a page with the deadline of the parse, which decides how much markup there is to clean.
+         *
+         * @param dl the deadline.
+         * @throw tidypp::timeout if the deadline has already expired.
+         * @throw tidypp::exception an exception that describes the general cause of the error.
+         */
+        void cleanandrepair(const deadline &dl) throw(const exception &);
+
         /**
          * Run configured diagnostics on parsed and repaired markup. Must call cleanandrepair() first.
          */
@@ -533,5 +683,96 @@ namespace tidypp
         bool nodehastext(const node &node) throw();
         void nodegettext(const node &node, buffer &buf) throw(const exception &);
         void nodegetvalue(const node &node, buffer &buf) throw(const exception &);
+
+        /**
+         * Takes a struct-of-arrays snapshot of the whole document tree, so that read-only analyses can scan flat
+         * arrays instead of chasing Tidy's node pointers. The snapshot is independent from the document.<br />
+         * The tree is walked once, without recursion.
+         *
+         * @param[out] tree the snapshot. Cleared first, its memory is reused.
+         * @param text if true, also copies the text of text nodes (through nodegetvalue()).
+         * @see flattree
+         */
+        void flatten(flattree &tree, bool text = false);
+
+        /**
+         * Finds all the elements that match a CSS selector, in document order.<br />
+         * When the same selector is used on many documents, compile it once and use the overload that takes a
+         * tidypp::selector.
+         *
+         * @param[in] text the selector, zero-terminated string. E.g. "div.article > a[href]".
+         * @return the matching nodes.
+         * @throw tidypp::exception an exception that describes the syntax error.
+         * @see selector
+         */
+        std::vector<node> select(ctmbstr text) throw(const exception &);
+
+        /**
+         * Finds all the elements that match a compiled CSS selector, in document order.
+         *
+         * @param sel the selector.
+         * @return the matching nodes.
+         */
+        std::vector<node> select(const selector &sel);
+
+        /**
+         * Gets all the elements with the given tag, in document order.<br />
+         * The first call walks the tree once and indexes every element by tag and by id attribute; later calls
+         * only look up the index. The index is dropped by parsebuffer(), parsesource() and cleanandrepair().
+         *
+         * @param tag the tag id.
+         * @return the matching nodes. Valid until the index is dropped.
+         * @see nodebyid()
+         */
+        const std::vector<node> &nodesbytag(tagid tag);
+
+        /**
+         * Gets the first element, in document order, whose id attribute equals the given value.
+         * Uses the same lazily built index as nodesbytag().
+         *
+         * @param[in] id the id value, zero-terminated string.
+         * @return the node, or an invalid node if no element has that id.
+         * @see basic_wrapper::valid()
+         */
+        node nodebyid(ctmbstr id);
+
+        /**
+         * Drops the tag and id indexes. Call this after changing the tree through the raw Tidy API, the
+         * document methods that change the tree already do it.
+         */
+        void invalidateindexes() throw();
+
+        /**
+         * Appends the text content of the whole document to a string, walking the tree once.<br />
+         * The raw text of each text node is copied straight from Tidy's lexer buffer, without going through the
+         * pretty printer like nodegettext() does, and a single scratch buffer is reused for the whole walk.
+         *
+         * @param[out] dst the string that receives the text. Existing content is kept.
+         * @param opts the extraction settings.
+         */
+        void extract_text(std::string &dst, const textoptions &opts = textoptions());
+
+        /**
+         * Walks the whole tree once, without recursion, and reports elements, text and comments to a visitor
+         * in document order. No node or attribute wrappers are created.
+         *
+         * @param v the visitor.
+         * @see visitor
+         */
+        void visit(visitor &v);
+
+    protected:
+        struct nodeindex; /**< @see nodesbytag() */
+
+        nodeindex *index; /**< Lazily built, NULL until needed. */
+        limits lim;
+        statistics st;
+        bool nodescounted; /**< st.nodes is up to date. */
+        hashvalue fingerprint; /**< Cached config_fingerprint(). */
+        bool fingerprinted; /**< fingerprint is up to date. */
+
+        nodeindex &getindex();
+        void checkinput(buffer &buf) const throw(const exception &);
+        void checktree() throw(const exception &);
     };
 }
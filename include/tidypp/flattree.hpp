@@ -0,0 +1,114 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "tidypp.hpp"
+#include <string>
+#include <vector>
+
+namespace tidypp
+{
+    /**
+     * Read-only struct-of-arrays snapshot of a parsed document, filled by document::flatten().<br />
+     * Node i is described by the i-th element of every per-node array; nodes are stored in document order
+     * (preorder) and node 0 is the root. Attributes of node i are attrids/attrnames/attrvalues
+     * [attrfirst[i], attrfirst[i + 1]). All strings live in a single arena and are referenced by offset and
+     * length.<br />
+     * The snapshot does not reference any Tidy memory, so the document can be released (or reused) as soon as
+     * it has been taken.<br /><br />
+     *
+     * Example:
+     * @verbatim
+       tidypp::flattree tree;
+       doc.flatten(tree);
+
+       for (tidypp::flattree::index i = 0; i < tree.size(); i++)
+       {
+           if (tree.tags[i] != TidyTag_A)
+               continue;
+
+           for (tidypp::flattree::index a = tree.attrfirst[i]; a < tree.attrfirst[i + 1]; a++)
+               if (tree.attrids[a] == TidyAttr_HREF)
+                   std::cout << tree.str(tree.attrvalues[a]) << std::endl;
+       }
+     * @endverbatim
+     */
+    struct flattree
+    {
+        typedef uint32_t index; /**< Index of a node or attribute. */
+
+        static const index npos = 0xffffffff; /**< No such node. */
+
+        /**
+         * A string in the arena.
+         */
+        struct strref
+        {
+            uint32_t offset; /**< Offset in the arena. */
+            uint32_t length; /**< Length in bytes, the string is also zero-terminated in the arena. */
+        };
+
+        // per-node arrays
+        std::vector<tagid> tags; /**< Tag id. */
+        std::vector<nodetype> types; /**< Node type. */
+        std::vector<index> parents; /**< Index of the parent, npos for the root. */
+        std::vector<index> firstchildren; /**< Index of the first child, npos if none. */
+        std::vector<index> nextsiblings; /**< Index of the next sibling, npos if none. */
+        std::vector<uint> lines; /**< Line of the node in the source. */
+        std::vector<uint> columns; /**< Column of the node in the source. */
+        std::vector<strref> names; /**< Tag name, empty for nodes without a name. */
+        std::vector<strref> texts; /**< Text content of text nodes, only filled if requested. */
+        std::vector<index> attrfirst; /**< Index of the first attribute; has size() + 1 elements. */
+
+        // per-attribute arrays
+        std::vector<attributeid> attrids; /**< Attribute id. */
+        std::vector<strref> attrnames; /**< Attribute name. */
+        std::vector<strref> attrvalues; /**< Attribute value, empty if the attribute has no value. */
+
+        std::string arena; /**< Storage for all the strings. */
+
+        /**
+         * Number of nodes.
+         * @return an unsigned integer.
+         */
+        index size() const throw();
+
+        /**
+         * Empties the snapshot, keeping the allocated memory for reuse.
+         */
+        void clear() throw();
+
+        /**
+         * Gets a string from the arena.
+         * @param ref the string reference.
+         * @return a zero-terminated string, valid until the snapshot is modified.
+         */
+        const char *str(const strref &ref) const throw();
+
+        /**
+         * Appends a string to the arena.
+         * @param[in] s the string, can be NULL.
+         * @param len length of the string.
+         * @return the reference to the stored string.
+         */
+        strref addstr(const char *s, size_t len);
+    };
+}
@@ -76,6 +76,19 @@ namespace tidypp
              * @return true if the input source reached eof, otherwise false.
              */
             bool eof() throw();
+
+            /**
+             * Helper: reads up to size bytes. Sources built on a buffer are copied in one go, the others are
+             * read through their callbacks.
+             *
+             * @param[out] dst where the bytes are stored.
+             * @param size maximum number of bytes to read.
+             * @return the number of bytes read, less than size only at the end of the input.
+             */
+            size_t read(byte *dst, size_t size) throw();
+
+        protected:
+            TidyBuffer *direct; /**< The buffer behind the source, if any. */
         };
     }
 }
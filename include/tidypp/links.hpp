@@ -0,0 +1,170 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "tidypp.hpp"
+#include <string>
+#include <vector>
+
+namespace tidypp
+{
+    // forward declarations
+    class document;
+
+    /**
+     * Reusable container for the links of a document, filled by extract_links().<br />
+     * Every distinct URL is stored once (interned) in a single arena and referenced by index; each occurrence
+     * in the document is recorded as a link that points to its URL. clear() keeps all the allocated memory, so a
+     * worker that reuses the same linkset for every page stops allocating after the first few.<br /><br />
+     *
+     * Example:
+     * @verbatim
+       tidypp::linkset links;
+
+       // [...] for each document
+       tidypp::extract_links(doc, links); // clears the set first
+
+       for (tidypp::linkset::index i = 0; i < links.urlcount(); i++)
+           std::cout << links.url(i) << std::endl; // each distinct url, in order of first appearance
+     * @endverbatim
+     */
+    class linkset
+    {
+    public:
+        typedef uint32_t index; /**< Index of a distinct URL. */
+
+        /**
+         * An occurrence of a URL in the document.
+         */
+        struct link
+        {
+            tagid tag; /**< The element that holds the URL. */
+            attributeid attr; /**< The attribute that holds the URL, TidyAttr_UNKNOWN for srcset. */
+            index url; /**< The URL, see url(). */
+        };
+
+        /**
+         * Default constructor.
+         */
+        linkset() throw();
+
+        /**
+         * Default destructor.
+         */
+        virtual ~linkset() throw();
+
+        /**
+         * Empties the set, keeping the allocated memory for reuse.
+         */
+        void clear() throw();
+
+        /**
+         * Adds a URL, storing it only if it isn't already in the set.
+         *
+         * @param[in] s the URL, not necessarily zero-terminated.
+         * @param len length of the URL in bytes.
+         * @return the index of the URL.
+         */
+        index intern(const char *s, size_t len);
+
+        /**
+         * Records an occurrence of a URL.
+         *
+         * @param tag the element that holds the URL.
+         * @param attr the attribute that holds the URL.
+         * @param[in] s the URL, not necessarily zero-terminated.
+         * @param len length of the URL in bytes.
+         */
+        void add(tagid tag, attributeid attr, const char *s, size_t len);
+
+        /**
+         * Number of distinct URLs.
+         * @return an unsigned integer.
+         */
+        index urlcount() const throw();
+
+        /**
+         * Gets a distinct URL.
+         * @param i the index of the URL.
+         * @return a zero-terminated string, valid until the set is modified.
+         */
+        const char *url(index i) const throw();
+
+        /**
+         * Gets the length of a distinct URL.
+         * @param i the index of the URL.
+         * @return the length in bytes.
+         */
+        size_t urllength(index i) const throw();
+
+        /**
+         * Gets every occurrence of a URL, in document order.
+         * @return the occurrences.
+         */
+        const std::vector<link> &links() const throw();
+
+        /**
+         * Gets the href of the document's base element, as found by extract_links().
+         * @return a zero-terminated string, empty if the document has no base element.
+         */
+        const std::string &base() const throw();
+
+        /**
+         * Sets the base URL that relative URLs passed to add() are resolved against.
+         * @param[in] href the base URL, empty to store URLs as they are.
+         */
+        void setbase(const std::string &href);
+
+    protected:
+        static const index npos = 0xffffffff;
+
+        std::string arena; /**< Zero-terminated URLs, back to back. */
+        std::vector<uint32_t> offsets; /**< Offset of each URL in the arena. */
+        std::vector<uint32_t> lengths; /**< Length of each URL. */
+        std::vector<index> table; /**< Open addressing table of URL indexes, kept at most half full. */
+        std::vector<link> occurrences;
+        std::string basehref;
+        std::string scratch; /**< Reused by add() to resolve relative URLs. */
+
+        void grow();
+    };
+
+    /**
+     * Collects the URLs of a parsed document in a single walk of the tree: href of a, area and link, src of img,
+     * script, iframe, frame, embed and input, action of form and every candidate of img srcset.<br />
+     * If the document has a base element with an href, relative URLs are resolved against it and the base is
+     * available through linkset::base(). Leading and trailing whitespace is stripped and empty URLs are skipped.
+     *
+     * @param doc the document, already parsed.
+     * @param[out] dst the set that receives the links. Cleared first, its memory is reused.
+     */
+    void extract_links(document &doc, linkset &dst);
+
+    /**
+     * Resolves a URL reference against a base URL, following RFC 3986 section 5.2.
+     *
+     * @param base the absolute base URL.
+     * @param[in] ref the reference, not necessarily zero-terminated.
+     * @param len length of the reference in bytes.
+     * @param[out] dst receives the resolved URL. Its previous content is replaced.
+     */
+    void resolveurl(const std::string &base, const char *ref, size_t len, std::string &dst);
+}
@@ -134,5 +134,158 @@ namespace tidypp
          * @param frealloc the replacement for realloc().
          */
         bool setrealloc(realloc frealloc);
+
+        /**
+         * Recycling allocator for a single thread.<br />
+         * Small blocks (up to 2 KB, which covers almost every allocation Tidy makes for nodes, attributes and
+         * strings) are kept in per-size free lists when freed and handed out again by the next allocations, so a
+         * thread that processes one document after another stops going to the system allocator after the first
+         * few. Bigger blocks go straight to malloc/realloc/free.<br />
+         * Not thread-safe: use one pool per thread, and only with documents and buffers used by that thread.
+         * The pool must outlive everything allocated from it.<br /><br />
+         *
+         * Example:
+         * @verbatim
+           tidypp::mem::pool pool;
+           tidypp::document doc(pool);
+           tidypp::buffer out(pool);
+         * @endverbatim
+         */
+        class pool : public allocator
+        {
+        public:
+            /**
+             * Default constructor.
+             */
+            pool() throw();
+
+            /**
+             * Default destructor. Releases the cached blocks.
+             */
+            virtual ~pool() throw();
+
+            /**
+             * Releases the cached blocks to the system allocator.
+             */
+            void trim() throw();
+
+            /**
+             * Bytes currently allocated from the pool and not yet freed.
+             * @return an unsigned integer.
+             */
+            size_t inuse() const throw();
+
+            /**
+             * Highest value reached by inuse().
+             * @return an unsigned integer.
+             */
+            size_t peak() const throw();
+
+            /**
+             * Starts measuring a new peak from the current inuse(), e.g. at the start of each document.
+             */
+            void resetpeak() throw();
+
+            /**
+             * Bytes held in the free lists, ready for reuse.
+             * @return an unsigned integer.
+             */
+            size_t cached() const throw();
+
+        protected:
+            static const size_t classcount = 8; /**< Size classes 16, 32, ..., 2048 bytes. */
+
+            struct freeblock
+            {
+                freeblock *next;
+            };
+
+            freeblock *freelists[classcount];
+            size_t used;
+            size_t peakused;
+            size_t cachedbytes;
+
+            static const allocatorvtbl poolvtbl;
+
+            static void *TIDY_CALL poolalloc(allocator *self, size_t size);
+            static void *TIDY_CALL poolrealloc(allocator *self, void *block, size_t size);
+            static void TIDY_CALL poolfree(allocator *self, void *block);
+            static void TIDY_CALL poolpanic(allocator *self, ctmbstr msg);
+
+        private:
+            // non-copyable
+            pool(const pool &);
+            pool &operator=(const pool &);
+        };
+
+        /**
+         * Routes Tidy's process-wide malloc/realloc/free/panic hooks to an allocator chosen by each thread.<br />
+         * Allocations that don't go through a document's own allocator (documents and buffers created without
+         * one) normally all land in the same global functions. Once routing is installed, each of them goes to
+         * the allocator the calling thread selected with setthreadallocator() or threadscope, or to the C
+         * library if it selected none. Every block remembers the allocator that made it and is freed or resized
+         * by that one, even if the thread has switched allocator in the meantime, so a per-thread mem::pool
+         * needs no locking.<br />
+         * Call it once, at startup, before any document or buffer is created: blocks made by the previous hooks
+         * can't be freed by the routing ones. It replaces any hook set with setmalloc() and friends, and further
+         * calls do nothing.<br />
+         * As with mem::pool, a block must be freed by the thread that owns its allocator, or when that allocator
+         * isn't being used by anyone else.
+         *
+         * Example:
+         * @verbatim
+           tidypp::mem::routethreads(); // in main()
+
+           // [...] on each worker thread
+           tidypp::mem::pool pool;
+           tidypp::mem::threadscope scope(pool);
+           tidypp::document doc; // allocates from pool
+         * @endverbatim
+         *
+         * @return true if the hooks were installed, otherwise false.
+         */
+        bool routethreads();
+
+        /**
+         * Selects the allocator used by the calling thread once routethreads() has been called.
+         *
+         * @param a the allocator, or NULL for the C library. It must outlive the blocks it allocates.
+         * @return the allocator that was selected before.
+         */
+        allocator *setthreadallocator(allocator *a) throw();
+
+        /**
+         * Gets the allocator selected by the calling thread.
+         * @return the allocator, NULL if the thread uses the C library.
+         */
+        allocator *getthreadallocator() throw();
+
+        /**
+         * Selects an allocator for the calling thread for the lifetime of the object, then restores the previous
+         * one.
+         * @see routethreads()
+         */
+        class threadscope
+        {
+        public:
+            /**
+             * Default constructor.
+             * @param a the allocator.
+             */
+            threadscope(allocator &a) throw();
+
+            /**
+             * Default destructor. Restores the previous allocator of the thread.
+             */
+            virtual ~threadscope() throw();
+
+        protected:
+            allocator *previous;
+
+        private:
+            // non-copyable
+            threadscope(const threadscope &);
+            threadscope &operator=(const threadscope &);
+        };
     }
 }
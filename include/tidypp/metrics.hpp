@@ -0,0 +1,269 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+#pragma once
+
+#include "tidypp.hpp"
+#include <stdint.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace tidypp
+{
+    // forward declarations
+    class document;
+
+    /**
+     * Thread-safe registry that aggregates document::stats() across any number of documents and threads, and
+     * exports the totals in the Prometheus text format.<br />
+     * Records go to one of several shards, each with its own lock; every thread sticks to one shard, so
+     * concurrent workers rarely contend. Shards are only merged when the totals are read.<br />
+     * Latencies and allocation peaks are kept in log-linear histograms (see histogram) so percentiles stay
+     * within a few percent whatever the range of the values.<br /><br />
+     *
+     * Example:
+     * @verbatim
+       tidypp::metrics registry;
+
+       // [...] on each worker thread, after processing a document
+       registry.record(doc);
+       registry.recordpeak(pool.peak());
+
+       // [...] periodically, for the node exporter textfile collector
+       registry.writeprometheus("/var/lib/node_exporter/tidypp.prom");
+     * @endverbatim
+     */
+    class metrics
+    {
+    public:
+        /**
+         * The timed phases, as in document::statistics.
+         */
+        enum phase
+        {
+            phase_parse,
+            phase_clean,
+            phase_diagnostics,
+            phase_save,
+            phasecount
+        };
+
+        /**
+         * HDR-style histogram of unsigned integers: each power of two is split in subcount linear buckets,
+         * so a bucket is never wider than 1/subcount of its values. Buckets include their upper edge, as
+         * Prometheus buckets do, so 2^k lands in the bucket that ends at 2^k. Values above 2^maxbits are not
+         * bucketed, but still count towards count(), sum() and max().<br />
+         * Not thread-safe by itself.
+         */
+        class histogram
+        {
+        public:
+            static const uint subbits = 4;
+            static const uint subcount = 1 << subbits; /**< Buckets per power of two. */
+            static const uint maxbits = 40; /**< Values up to 2^maxbits are bucketed. */
+            static const uint bucketcount = subcount + (maxbits - subbits) * subcount;
+
+            /**
+             * Default constructor. Creates an empty histogram.
+             */
+            histogram() throw();
+
+            /**
+             * Adds a value.
+             * @param value the value.
+             */
+            void record(uint64_t value) throw();
+
+            /**
+             * Adds all the values of another histogram.
+             * @param[in] other the histogram to add.
+             */
+            void merge(const histogram &other) throw();
+
+            /**
+             * Removes all the values.
+             */
+            void clear() throw();
+
+            /**
+             * Number of values.
+             * @return an unsigned integer.
+             */
+            uint64_t count() const throw();
+
+            /**
+             * Sum of the values.
+             * @return an unsigned integer.
+             */
+            uint64_t sum() const throw();
+
+            /**
+             * Largest value.
+             * @return an unsigned integer, 0 if the histogram is empty.
+             */
+            uint64_t max() const throw();
+
+            /**
+             * Estimates a quantile.
+             *
+             * @param q the quantile, between 0 and 1 (e.g. 0.99).
+             * @return the upper bound of the bucket that holds the quantile, never more than max().
+             */
+            uint64_t quantile(double q) const throw();
+
+            /**
+             * Number of values less than or equal to a bound. Exact when the bound is a nonzero bucket edge, as
+             * the powers of two up to 2^maxbits are; values above 2^maxbits are never counted.
+             *
+             * @param bound the bound, included.
+             * @return an unsigned integer.
+             */
+            uint64_t countupto(uint64_t bound) const throw();
+
+        protected:
+            uint64_t buckets[bucketcount];
+            uint64_t n;
+            uint64_t total;
+            uint64_t highest;
+
+            static uint bucketof(uint64_t value) throw();
+            static uint64_t lowerbound(uint b) throw();
+        };
+
+        /**
+         * Everything recorded so far, merged across shards.
+         */
+        struct totals
+        {
+            histogram phases[phasecount]; /**< Wall-clock microseconds of each phase, per document. */
+            double cpu[phasecount]; /**< CPU seconds spent in each phase. */
+            histogram peaks; /**< Allocation peaks in bytes, see recordpeak(). */
+            uint64_t documents; /**< Documents recorded. */
+            uint64_t failures; /**< Documents recorded as failed. */
+            uint64_t bytesin;
+            uint64_t bytesout;
+            uint64_t nodes;
+            uint64_t errors; /**< Sum of document::errorcount() */
+            uint64_t warnings; /**< Sum of document::warningcount() */
+
+            totals() throw();
+
+            /**
+             * Adds the values of other totals.
+             * @param[in] other the totals to add.
+             */
+            void merge(const totals &other) throw();
+        };
+
+        /**
+         * Default constructor.
+         * @param shards number of independently locked shards, 0 for one per hardware thread. Rounded up to a
+         *        power of two.
+         */
+        metrics(size_t shards = 0);
+
+        /**
+         * Default destructor.
+         */
+        virtual ~metrics() throw();
+
+        /**
+         * Records a processed document: the timings and sizes of document::stats(), the error and warning
+         * counts. Call it once per input, after the last phase. Phases that didn't run are not recorded.<br />
+         * NOTE: with a library built with TIDYPP_NO_STATS there are no timings, only counts and sizes.
+         *
+         * @param doc the document.
+         * @param ok false to also count the document as failed.
+         */
+        void record(document &doc, bool ok = true);
+
+        /**
+         * Records the time spent in a phase, for work timed outside of a document.
+         *
+         * @param p the phase.
+         * @param wall wall-clock seconds.
+         * @param cpu CPU seconds.
+         */
+        void recordphase(phase p, double wall, double cpu = 0);
+
+        /**
+         * Records the allocation peak of a document, e.g. mem::pool::peak() after mem::pool::resetpeak() at
+         * the start of each input.
+         *
+         * @param bytes the peak in bytes.
+         */
+        void recordpeak(size_t bytes);
+
+        /**
+         * Merges all the shards.
+         * @param[out] dst receives the totals.
+         */
+        void collect(totals &dst);
+
+        /**
+         * Drops everything recorded so far.
+         */
+        void reset();
+
+        /**
+         * Exports the totals in the Prometheus text format (version 0.0.4). Latencies are exported in seconds
+         * and allocation peaks in bytes, as histograms with a bucket for each power of two.
+         *
+         * @param[out] dst the text is appended here.
+         * @param prefix prepended to the name of every metric.
+         */
+        void prometheus(std::string &dst, const std::string &prefix = "tidypp");
+
+        /**
+         * Exports the totals in the Prometheus text format.
+         *
+         * @param prefix prepended to the name of every metric.
+         * @return the text.
+         */
+        std::string prometheus(const std::string &prefix = "tidypp");
+
+        /**
+         * Exports the totals in the Prometheus text format to a file. The text is written to a temporary file
+         * next to it that then replaces it, so a scraper never reads half a file.
+         *
+         * @param path the file.
+         * @param prefix prepended to the name of every metric.
+         * @throw tidypp::exception an exception that describes the general cause of the error.
+         */
+        void writeprometheus(const std::string &path, const std::string &prefix = "tidypp")
+            throw(const exception &);
+
+    protected:
+        struct shard
+        {
+            std::mutex lock;
+            totals data;
+        };
+
+        std::vector<shard *> shards;
+
+        shard &getshard() throw();
+
+    private:
+        // non-copyable
+        metrics(const metrics &);
+        metrics &operator=(const metrics &);
+    };
+}
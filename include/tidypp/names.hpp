@@ -0,0 +1,56 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "strview.hpp"
+
+namespace tidypp
+{
+    /**
+     * Looks up the id of an HTML tag by name, ignoring case.<br />
+     * Uses a hash table built on first use, so a lookup is one hash and one string compare.
+     *
+     * @param name the tag name, e.g. "div".
+     * @return the tag id, or TidyTag_UNKNOWN if the name is not a tag known to Tidy.
+     */
+    tagid lookuptag(strview name) throw();
+
+    /**
+     * Looks up the id of an HTML attribute by name, ignoring case.<br />
+     * Uses a hash table built on first use, so a lookup is one hash and one string compare.
+     *
+     * @param name the attribute name, e.g. "href".
+     * @return the attribute id, or TidyAttr_UNKNOWN if the name is not in the table (e.g. data-* attributes).
+     */
+    attributeid lookupattribute(strview name) throw();
+
+    /**
+     * Finds an attribute of an element by name, ignoring case.<br />
+     * Names in the lookupattribute() table are found with tidyAttrGetById(). Other names (e.g. data-* and
+     * aria-*) need a scan of the attributes of the element, which checks the length of each name before
+     * comparing it.
+     *
+     * @param n the element.
+     * @param name the attribute name.
+     * @return the attribute, NULL if the element doesn't have it.
+     */
+    TidyAttr findattribute(TidyNode n, strview name) throw();
+}
@@ -22,6 +22,11 @@
 
 #include "basic_wrapper.hpp"
 #include "document.hpp"
+#include "range.hpp"
+#include "strview.hpp"
+#include "tagset.hpp"
+#include <iterator>
+#include <stddef.h>
 
 namespace tidypp
 {
@@ -40,8 +45,27 @@ namespace tidypp
         friend bool document::nodehastext(const node &node) throw();
         friend void document::nodegettext(const node &node, buffer &buf) throw(const exception &);
         friend void document::nodegetvalue(const node &node, buffer &buf) throw(const exception &);
+        friend class selector;
+        friend class queryset;
 
     public:
+        /**
+         * Traversal orders for descendants().
+         */
+        enum order
+        {
+            preorder, /**< Every node before its children, in document order. */
+            postorder /**< Every node after its children. */
+        };
+
+        class child_iterator;
+        class descendant_iterator;
+        class attribute_iterator;
+
+        typedef range<child_iterator> child_range; /**< @see children() */
+        typedef range<descendant_iterator> descendant_range; /**< @see descendants() */
+        typedef range<attribute_iterator> attribute_range; /**< @see attributes() */
+
         /**
          * Default constructor
          */
@@ -53,6 +77,13 @@ namespace tidypp
          */
         node(const node &other) throw();
 
+        /**
+         * Assignment operator
+         * @param other the node to copy.
+         * @return this node.
+         */
+        node &operator=(const node &other) throw();
+
         /**
          * Default destructor
          */
@@ -88,6 +119,46 @@ namespace tidypp
          */
         attribute attrfirst() throw();
 
+        /**
+         * Get the attributes of this node as a range. Needs attribute.hpp.<br /><br />
+         *
+         * Example:
+         * @verbatim
+           for (tidypp::attribute &attr : mynode.attributes())
+               std::cout << attr.name() << "=" << attr.value() << std::endl;
+         * @endverbatim
+         *
+         * @return the range of attributes.
+         */
+        attribute_range attributes() throw();
+
+        /**
+         * Get the children of this node as a range.<br /><br />
+         *
+         * Example:
+         * @verbatim
+           for (tidypp::node &child : mynode.children())
+               std::cout << child.name() << std::endl;
+         * @endverbatim
+         *
+         * @return the range of child nodes.
+         */
+        child_range children() throw();
+
+        /**
+         * Get all the nodes below this node (the node itself excluded) as a range.<br /><br />
+         *
+         * Example:
+         * @verbatim
+           tidypp::node::descendant_range all = doc.root().descendants();
+           size_t links = std::count_if(all.begin(), all.end(), [](tidypp::node &n) { return n.id() == TidyTag_A; });
+         * @endverbatim
+         *
+         * @param ord the traversal order.
+         * @return the range of descendant nodes.
+         */
+        descendant_range descendants(order ord = preorder) throw();
+
         /**
          * Get the type of the node.
          * @return the node type.
@@ -101,6 +172,12 @@ namespace tidypp
          */
         ctmbstr name() throw();
 
+        /**
+         * Get the name of the node along with its length.
+         * @return a view of the name, empty for nodes without a name.
+         */
+        strview nameview() throw();
+
         /**
          * Lookup an attribute from the node.
          * @param id the attribute id to look for.
@@ -109,6 +186,35 @@ namespace tidypp
          */
         attribute attrgetbyid(attributeid id) throw();
 
+        /**
+         * Lookup an attribute from the node by name, ignoring case.<br />
+         * Names known to Tidy are resolved to their id through a precomputed hash table (see lookupattribute())
+         * and found with integer compares; other names (e.g. data-* and aria-*) need a scan of the attributes,
+         * which compares lengths before names. See findattribute().
+         *
+         * @param name the attribute name.
+         * @return the attribute, invalid if the node doesn't have it.
+         */
+        attribute attr(strview name) throw();
+
+        /**
+         * Checks if the tag of this node is in the given set, with a single id lookup.<br /><br />
+         *
+         * Example:
+         * @verbatim
+           if (mynode.in(tidypp::tags::blocks))
+               // ...
+         * @endverbatim
+         *
+         * @param set the tag set.
+         * @return true if the node's tag id is in the set, otherwise false.
+         * @see tagset
+         */
+        bool in(const tagset &set) throw()
+        {
+            return set.contains(id());
+        }
+
         bool istext() throw();
         bool isheader() throw();
         tagid id() throw();
@@ -203,4 +309,77 @@ namespace tidypp
          */
         node(const TidyNode &data) throw();
     };
+
+    /**
+     * Forward iterator over the children of a node.<br />
+     * The referenced node lives inside the iterator, copy it if you need it after incrementing.
+     * @see children()
+     */
+    class node::child_iterator
+    {
+        friend class node;
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef node value_type;
+        typedef ptrdiff_t difference_type;
+        typedef node *pointer;
+        typedef node &reference;
+
+        /**
+         * Default constructor. Creates a past-the-end iterator.
+         */
+        child_iterator() throw();
+
+        node &operator*() const throw();
+        node *operator->() const throw();
+        child_iterator &operator++() throw();
+        child_iterator operator++(int) throw();
+        bool operator==(const child_iterator &other) const throw();
+        bool operator!=(const child_iterator &other) const throw();
+
+    protected:
+        mutable node cur;
+
+        child_iterator(const TidyNode &first) throw();
+    };
+
+    /**
+     * Forward iterator over all the nodes below a node, in preorder or postorder.<br />
+     * The traversal moves through child(), next() and parent() only, so it uses constant memory no matter how
+     * deeply the document is nested.<br />
+     * The referenced node lives inside the iterator, copy it if you need it after incrementing.
+     * @see descendants()
+     */
+    class node::descendant_iterator
+    {
+        friend class node;
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef node value_type;
+        typedef ptrdiff_t difference_type;
+        typedef node *pointer;
+        typedef node &reference;
+
+        /**
+         * Default constructor. Creates a past-the-end iterator.
+         */
+        descendant_iterator() throw();
+
+        node &operator*() const throw();
+        node *operator->() const throw();
+        descendant_iterator &operator++() throw();
+        descendant_iterator operator++(int) throw();
+        bool operator==(const descendant_iterator &other) const throw();
+        bool operator!=(const descendant_iterator &other) const throw();
+
+    protected:
+        mutable node cur;
+        TidyNode root; /**< The traversal never leaves the subtree of this node. */
+        order ord;
+
+        descendant_iterator(const TidyNode &root, order ord) throw();
+        static TidyNode leftmostleaf(TidyNode n) throw();
+    };
 }
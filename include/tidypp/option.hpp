@@ -125,10 +125,11 @@ namespace tidypp
         ctmbstr nextpick(iterator *it) throw();
 
         /**
-         * Get option ID by name.
+         * Get option ID by name. Uses a hash table that is built from Tidy's option list on the first call,
+         * so repeated lookups do not scan the whole option table.
          *
          * @param name the option name.
-         * @return the matching option id.
+         * @return the matching option id, or N_TIDY_OPTIONS if there is no option with that name.
          */
         static optionid getidbyname(ctmbstr name) throw();
 
@@ -0,0 +1,227 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "batch.hpp"
+#include <atomic>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tidypp
+{
+    // forward declarations
+    class document;
+
+    namespace io
+    {
+        class outputsink;
+    }
+
+    /**
+     * Runs read, parse, clean and save as separate stages, each on its own threads, connected by bounded
+     * lock-free queues.<br />
+     * Unlike batch, where one thread takes an item from start to finish, a document here moves from stage to
+     * stage, so a reader blocked on disk or a writer blocked on a sink doesn't keep a CPU idle: I/O-bound and
+     * CPU-bound work overlap and each stage gets as many threads as it needs.<br />
+     * Documents live in a fixed set of slots (config::inflight), each with its own mem::pool, document and
+     * buffers. A reader has to wait for a free slot before starting an item, so a slow stage pushes back on the
+     * ones before it and the memory in use stays bounded however many items are queued.<br /><br />
+     *
+     * Example:
+     * @verbatim
+       tidypp::pipeline::config cfg;
+       cfg.readers = 2; // e.g. slow network storage
+       cfg.parsers = 6;
+       cfg.cleaners = 6;
+       cfg.writers = 1;
+       cfg.options.push_back(std::make_pair("force-output", "yes"));
+
+       tidypp::pipeline p(cfg);
+
+       for (const std::string &path : paths)
+           p.add(tidypp::pipeline::item::file(path));
+
+       const tidypp::pipeline::summary &s = p.run();
+       std::cout << s.throughput() / 1048576 << " MB/s, parse busy " << s.busy[tidypp::pipeline::stage_parse]
+                 << "s" << std::endl;
+     * @endverbatim
+     *
+     * @see batch
+     */
+    class pipeline
+    {
+    public:
+        typedef batch::item item; /**< An input, see batch::item. */
+        typedef batch::result result; /**< The outcome of an item, see batch::result. */
+        typedef batch::outputmode outputmode; /**< What to keep of each document, see batch::outputmode. */
+        typedef batch::processfunc processfunc; /**< Custom work on each document, see batch::processfunc. */
+
+        /**
+         * The stages, in the order a document goes through them.
+         */
+        enum stage
+        {
+            stage_read, /**< Reads (or decompresses) the input into memory. */
+            stage_parse, /**< parsebuffer() */
+            stage_clean, /**< cleanandrepair() and rundiagnostics(), as configured. */
+            stage_save, /**< savebuffer(), savesink() or extract_text(), then config::process. */
+            stagecount
+        };
+
+        /**
+         * Replaces the default reader: fills dst with the whole input of an item (e.g. reads and decompresses a
+         * .gz file). Receives the index of the item, the item and the destination, which keeps its memory from
+         * one item to the next. Throw to fail the item. Must be thread-safe.
+         */
+        typedef std::function<void(size_t, const item &, std::vector<byte> &)> readfunc;
+
+        /**
+         * Gives the sink that receives the saved document of an item, by index. Must be thread-safe.
+         */
+        typedef std::function<io::outputsink &(size_t)> sinkfunc;
+
+        /**
+         * Totals of the last run().
+         */
+        struct summary
+        {
+            size_t items; /**< Items processed. */
+            size_t failed; /**< Items with ok == false. */
+            uint64_t bytesin; /**< Input bytes. */
+            uint64_t bytesout; /**< Output bytes. */
+            double seconds; /**< Wall-clock time of the run. */
+            size_t threads; /**< Threads used, all stages. */
+            size_t inflight; /**< Documents that could be in flight at once. */
+            double busy[stagecount]; /**< Seconds spent working by the threads of each stage, waits excluded. */
+
+            summary() throw();
+
+            /**
+             * Input bytes processed per second of wall-clock time.
+             * @return the throughput, 0 for an empty run.
+             */
+            double throughput() const throw();
+        };
+
+        /**
+         * Settings shared by all the stages.
+         */
+        struct config
+        {
+            size_t readers; /**< Threads of the read stage. */
+            size_t parsers; /**< Threads of the parse stage, 0 for half the hardware threads. */
+            size_t cleaners; /**< Threads of the clean stage, 0 for half the hardware threads. */
+            size_t writers; /**< Threads of the save stage. */
+            size_t inflight; /**< Maximum documents in flight, 0 for twice the total number of threads. */
+            std::string configfile; /**< Tidy configuration file to load, if not empty. */
+            std::vector<std::pair<std::string, std::string> > options; /**< Applied with optparsevalue(). */
+            std::function<void(document &)> setup; /**< Optional, called once on each new slot document. */
+            bool clean; /**< Run cleanandrepair() after parsing. */
+            bool diagnostics; /**< Run rundiagnostics() after cleaning. */
+            outputmode output; /**< What to keep of each document. */
+            readfunc read; /**< Optional, custom reader. Sources are otherwise drained into memory. */
+            sinkfunc sink; /**< Optional, with output_save the document goes to this sink instead of result::output. */
+            processfunc process; /**< Optional, custom work on each document, in the save stage. */
+
+            /**
+             * Default constructor. One reader, one writer, clean, save output.
+             */
+            config() throw();
+        };
+
+        /**
+         * Default constructor.
+         * @param cfg the settings, copied.
+         */
+        pipeline(const config &cfg);
+
+        /**
+         * Default destructor. Releases the slots.
+         */
+        virtual ~pipeline() throw();
+
+        /**
+         * Queues an input for the next run().
+         * @param it the input.
+         */
+        void add(const item &it);
+
+        /**
+         * Number of queued inputs.
+         * @return an unsigned integer.
+         */
+        size_t size() const throw();
+
+        /**
+         * Drops the queued inputs and the results.
+         */
+        void clear() throw();
+
+        /**
+         * Processes all the queued inputs and waits for them. Results are stored in the same order as the inputs,
+         * with result::seconds measured from the start of the read to the end of the save, waits included.
+         * The inputs stay queued, so run() can be called again.
+         *
+         * @return the totals of this run.
+         * @throw tidypp::exception if a slot document cannot be configured.
+         */
+        const summary &run() throw(const exception &);
+
+        /**
+         * Gets the results of the last run(), one per input.
+         * @return the results.
+         */
+        const std::vector<result> &results() const throw();
+
+        /**
+         * Gets the totals of the last run().
+         * @return the totals.
+         */
+        const summary &totals() const throw();
+
+    protected:
+        struct slot; /**< Allocator, document and buffers of a document in flight. */
+        class ring; /**< Bounded lock-free queue of slots between two stages. */
+
+        config cfg;
+        std::vector<item> items;
+        std::vector<result> res;
+        std::vector<slot *> slots;
+        std::atomic<size_t> next; /**< Next item for the read stage. */
+        summary sum;
+
+        void readmain(ring &in, ring &out, double &busy) throw();
+        void stagemain(stage st, ring &in, ring &out, double &busy) throw();
+        void read(slot &s) throw();
+        void parse(slot &s) throw();
+        void clean(slot &s) throw();
+        void save(slot &s) throw();
+        void fail(slot &s, const char *message) throw();
+        slot *makeslot() throw(const exception &);
+
+    private:
+        // non-copyable
+        pipeline(const pipeline &);
+        pipeline &operator=(const pipeline &);
+    };
+}
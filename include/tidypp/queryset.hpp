@@ -0,0 +1,140 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "selector.hpp"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tidypp
+{
+    /**
+     * A set of CSS selectors evaluated together in a single traversal of the tree.<br />
+     * Every complex selector is filed under the id, the class or the tag of its rightmost compound (the one that
+     * must match the node itself), in this order of preference, so at each element only the rules that can
+     * possibly match it are tried: the cost grows with the size of the tree and the number of actual
+     * candidates, not with tree size × number of rules. Only rules whose rightmost compound has none of them
+     * (e.g. "*", "[href]" or an unknown tag) are tried on every element.<br /><br />
+     *
+     * Example:
+     * @verbatim
+       tidypp::queryset rules;
+       size_t title = rules.add("head > title");
+       size_t links = rules.add("a[href]");
+       size_t prices = rules.add("span.price, div.price");
+
+       // [...] for each document
+       std::vector<tidypp::queryset::match> found;
+       rules.run(doc.root(), found);
+
+       for (tidypp::queryset::match &m : found)
+           if (m.query == links)
+               // [...] m.n is an <a href> element
+     * @endverbatim
+     *
+     * @see selector
+     */
+    class queryset
+    {
+    public:
+        /**
+         * A node matched by one of the queries.
+         */
+        struct match
+        {
+            size_t query; /**< The id returned by add(). */
+            node n; /**< The matching element. */
+        };
+
+        /**
+         * Default constructor. Creates an empty set.
+         */
+        queryset() throw();
+
+        /**
+         * Default destructor.
+         */
+        virtual ~queryset() throw();
+
+        /**
+         * Compiles a selector and adds it to the set.
+         *
+         * @param[in] text the selector, zero-terminated string.
+         * @return the query id, i.e. the number of queries added before this one.
+         * @throw tidypp::exception an exception that describes the syntax error.
+         */
+        size_t add(ctmbstr text) throw(const exception &);
+
+        /**
+         * Adds an already compiled selector to the set.
+         *
+         * @param sel the selector, copied.
+         * @return the query id, i.e. the number of queries added before this one.
+         */
+        size_t add(const selector &sel);
+
+        /**
+         * Number of queries in the set.
+         * @return an unsigned integer.
+         */
+        size_t size() const throw();
+
+        /**
+         * Gets a query.
+         *
+         * @param query the query id.
+         * @return the compiled selector.
+         */
+        const selector &get(size_t query) const throw();
+
+        /**
+         * Evaluates all the queries on the elements below the given node, walking the tree once.<br />
+         * Matches are emitted in document order and, for the same node, by increasing query id. A node is
+         * reported at most once per query, even when more than one selector of a list matches it.
+         *
+         * @param n the node where the search starts (not included in the results).
+         * @param[out] dst the matches are appended here.
+         */
+        void run(node &n, std::vector<match> &dst) const;
+
+    protected:
+        /**
+         * Reference to one complex selector of one query.
+         */
+        struct rule
+        {
+            size_t query;
+            size_t chain;
+        };
+
+        typedef std::vector<rule> rulelist; /**< Sorted by query id. */
+
+        std::vector<selector> queries;
+        std::unordered_map<std::string, rulelist> byid; /**< Rules whose rightmost compound has an #id. */
+        std::unordered_map<std::string, rulelist> byclass; /**< Rules whose rightmost compound has a .class. */
+        rulelist bytag[N_TIDY_TAGS]; /**< Rules whose rightmost compound has a known tag. */
+        rulelist anytag; /**< All the other rules. */
+
+        void candidates(TidyNode n, std::vector<rule> &dst) const;
+        static bool byquery(const rule &a, const rule &b) throw();
+    };
+}
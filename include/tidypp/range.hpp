@@ -0,0 +1,78 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+namespace tidypp
+{
+    /**
+     * A pair of iterators that can be used in range-based for loops and passed to <algorithm>.
+     * @see node::children()
+     * @see node::descendants()
+     */
+    template <class T>
+    class range
+    {
+    public:
+        typedef T iterator; /**< The iterator type. */
+
+        /**
+         * Default constructor.
+         * @param first iterator to the first element.
+         * @param last iterator past the last element.
+         */
+        range(const T &first, const T &last) throw()
+            : first(first), last(last)
+        {
+            // empty
+        }
+
+        /**
+         * Iterator to the first element.
+         * @return the iterator.
+         */
+        T begin() const throw()
+        {
+            return first;
+        }
+
+        /**
+         * Iterator past the last element.
+         * @return the iterator.
+         */
+        T end() const throw()
+        {
+            return last;
+        }
+
+        /**
+         * Checks if the range has no elements.
+         * @return true if the range is empty, otherwise false.
+         */
+        bool empty() const throw()
+        {
+            return first == last;
+        }
+
+    protected:
+        T first;
+        T last;
+    };
+}
@@ -0,0 +1,228 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "tidypp.hpp"
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tidypp
+{
+    // forward declarations
+    class document;
+    class buffer;
+    class disk_cache;
+
+    /**
+     * Content-addressed, thread-safe LRU cache of cleaned documents.<br />
+     * Sits in front of document::parsebuffer(), document::cleanandrepair() and document::savebuffer():
+     * results are keyed by a hash of the input bytes and by document::config_fingerprint(), so the same page
+     * processed with the same settings is only cleaned once.<br />
+     * The cache is split in shards, each with its own lock and its own share of the byte capacity, so that
+     * concurrent workers rarely contend.<br /><br />
+     *
+     * Example:
+     * @verbatim
+       tidypp::result_cache cache(64 * 1024 * 1024); // 64 MB
+
+       // [...] on each worker thread
+       tidypp::document doc;
+       tidypp::buffer out;
+
+       doc.optsetbool(TidyForceOutput, true);
+       cache.process(doc, html, out); // only parses and cleans on a miss
+     * @endverbatim
+     */
+    class result_cache
+    {
+    public:
+        /**
+         * Identifies a cached result.
+         */
+        struct key
+        {
+            hashvalue content; /**< fasthash() of the input bytes. */
+            hashvalue config; /**< document::config_fingerprint() of the document. */
+            size_t size; /**< Input size in bytes, to make accidental collisions even less likely. */
+
+            bool operator==(const key &other) const throw();
+        };
+
+        /**
+         * A cleaned document along with its diagnostics.
+         */
+        struct result
+        {
+            std::string output; /**< The saved document. */
+            int status; /**< document::status() after savebuffer(). */
+            uint errors; /**< document::errorcount() */
+            uint warnings; /**< document::warningcount() */
+            uint accesswarnings; /**< document::accesswarningcount() */
+
+            result() throw();
+        };
+
+        /**
+         * Creates an empty cache.
+         *
+         * @param capacity maximum amount of bytes of cached output (plus bookkeeping) across all shards.
+         * @param shards number of independently locked shards. Rounded up to a power of two.
+         */
+        result_cache(size_t capacity, size_t shards = 16);
+
+        /**
+         * Default destructor.
+         */
+        virtual ~result_cache() throw();
+
+        /**
+         * Builds the cache key for some input, processed by the given document with its current settings.
+         *
+         * @param doc the document whose settings will be used.
+         * @param[in] data pointer to the input bytes.
+         * @param size size of the input in bytes.
+         * @return the key.
+         */
+        static key makekey(document &doc, const void *data, size_t size) throw();
+
+        /**
+         * Looks up a result and marks it as most recently used.
+         *
+         * @param k the key.
+         * @param[out] res receives a copy of the cached result on a hit.
+         * @return true on a hit, otherwise false.
+         */
+        bool find(const key &k, result &res);
+
+        /**
+         * Stores a result, evicting the least recently used ones of its shard if needed.
+         * Results bigger than the capacity of a shard are not stored.
+         *
+         * @param k the key.
+         * @param[in] res the result.
+         */
+        void insert(const key &k, const result &res);
+
+        /**
+         * Parses, cleans and saves the given input, or appends the cached output to buf if the same input has
+         * already been processed with the same settings. On a miss the result is added to the cache.
+         * If a disk cache is set, it is checked before parsing; failing to store a result on disk is ignored.<br />
+         * Errors in the markup don't fail the call, they end up in the result's status and counters, but
+         * without TidyForceOutput such a document has no output and is rejected.<br />
+         * NOTE: on a hit the document is not touched, so it doesn't hold a parsed tree. Use the returned
+         * diagnostics instead of the document's counters.
+         *
+         * @param doc the document that will do the work on a miss.
+         * @param[in] input the markup to process.
+         * @param[out] buf the buffer that will receive the cleaned document.
+         * @param[out] info optional, receives the diagnostics of the result.
+         * @return true if the result came from the cache, otherwise false.
+         * @throw tidypp::exception an exception that describes the general cause of the error.
+         */
+        bool process(document &doc, buffer &input, buffer &buf, result *info = NULL) throw(const exception &);
+
+        /**
+         * Sets a persistent second tier. process() looks up results that are not in memory in the disk cache
+         * before parsing, and stores new results in both. The disk cache must outlive this object.
+         *
+         * @param[in] disk the disk cache, or NULL to disable the second tier.
+         * @see disk_cache
+         */
+        void setdiskcache(disk_cache *disk) throw();
+
+        /**
+         * Drops all cached results. Counters are not reset.
+         */
+        void clear();
+
+        /**
+         * Number of successful lookups so far.
+         * @return an unsigned integer.
+         */
+        uint64_t hits();
+
+        /**
+         * Number of failed lookups so far.
+         * @return an unsigned integer.
+         */
+        uint64_t misses();
+
+        /**
+         * Number of cached results.
+         * @return an unsigned integer.
+         */
+        size_t count();
+
+        /**
+         * Bytes currently used by cached results, bookkeeping included.
+         * @return an unsigned integer.
+         */
+        size_t bytes();
+
+        /**
+         * Maximum amount of bytes, as given to the constructor.
+         * @return an unsigned integer.
+         */
+        size_t capacity() throw();
+
+    protected:
+        struct keyhash
+        {
+            size_t operator()(const key &k) const throw();
+        };
+
+        struct entry
+        {
+            key k;
+            result res;
+        };
+
+        typedef std::list<entry> lrulist; /**< Most recently used first. */
+
+        struct shard
+        {
+            std::mutex lock;
+            lrulist lru;
+            std::unordered_map<key, lrulist::iterator, keyhash> index;
+            size_t bytes;
+            uint64_t hits;
+            uint64_t misses;
+
+            shard() throw();
+        };
+
+        size_t cap; /**< Total capacity in bytes. */
+        size_t shardcap; /**< Capacity of a single shard in bytes. */
+        std::vector<shard *> shards;
+        disk_cache *disk; /**< Optional second tier. */
+
+        shard &getshard(const key &k) throw();
+        static size_t cost(const entry &e) throw();
+
+    private:
+        // non-copyable
+        result_cache(const result_cache &);
+        result_cache &operator=(const result_cache &);
+    };
+}
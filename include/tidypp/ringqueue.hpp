@@ -0,0 +1,310 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace tidypp
+{
+    /**
+     * Bounded lock-free multi-producer multi-consumer queue, for handing documents, buffers or anything else
+     * that is expensive to copy between threads.<br />
+     * Elements are moved in and out, so move-only handles such as std::unique_ptr<tidypp::document> work, and
+     * the ring never allocates after construction. Each cell carries a sequence number that tells whether it
+     * can be written or read on the current lap (D. Vyukov's bounded queue): producers only contend on the
+     * tail index and consumers on the head index, with one compare-and-swap per operation, or per group of
+     * elements with trypushbulk() / trypopbulk(), which also amortizes the cache misses on the shared indexes.
+     * <br />
+     * The try functions never block. push() and pop() wait for room or for an element by yielding and then
+     * sleeping briefly, which suits pipelines where a stage would otherwise sit on a condition variable.
+     * <br /><br />
+     *
+     * Example:
+     * @verbatim
+       tidypp::ringqueue<std::unique_ptr<tidypp::document> > parsed(256);
+
+       // [...] on a parser thread
+       std::unique_ptr<tidypp::document> doc(new tidypp::document);
+       doc->parsebuffer(html);
+       parsed.push(std::move(doc));
+
+       // [...] on a writer thread
+       std::unique_ptr<tidypp::document> next;
+       parsed.pop(next);
+       next->savefile(path);
+     * @endverbatim
+     */
+    template <class T>
+    class ringqueue
+    {
+    public:
+        typedef T value_type; /**< The element type. */
+
+        /**
+         * Default constructor.
+         * @param capacity maximum number of elements, rounded up to a power of two.
+         */
+        explicit ringqueue(size_t capacity)
+            : head(0), tail(0)
+        {
+            size_t size = 2; // with a single cell, a released cell would look ready for the next lap
+
+            while (size < capacity)
+                size <<= 1;
+
+            cells = new cell[size];
+            mask = size - 1;
+
+            for (size_t i = 0; i < size; i++)
+                cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+
+        /**
+         * Default destructor. Destroys the elements still queued. No other thread may use the queue.
+         */
+        virtual ~ringqueue() throw()
+        {
+            T dropped;
+
+            while (trypop(dropped));
+
+            delete[] cells;
+        }
+
+        /**
+         * Moves an element into the queue, if there is room.
+         *
+         * @param v the element, left untouched if the queue is full.
+         * @return true if the element was queued, false if the queue is full.
+         */
+        bool trypush(T &&v) throw()
+        {
+            size_t pos;
+
+            if (!claim(tail, 0, 1, pos))
+                return false;
+
+            put(pos, v);
+            return true;
+        }
+
+        /**
+         * Moves an element out of the queue, if there is one.
+         *
+         * @param[out] v receives the element.
+         * @return true if an element was dequeued, false if the queue is empty.
+         */
+        bool trypop(T &v) throw()
+        {
+            size_t pos;
+
+            if (!claim(head, 1, 1, pos))
+                return false;
+
+            take(pos, v);
+            return true;
+        }
+
+        /**
+         * Moves as many elements as there is room for, in order, with a single claim on the tail.
+         *
+         * @param[in] v the first of the elements. The ones that are queued are moved from.
+         * @param count number of elements.
+         * @return the number of elements queued, from the first one, 0 if the queue is full.
+         */
+        size_t trypushbulk(T *v, size_t count) throw()
+        {
+            size_t pos;
+            size_t n = claim(tail, 0, count, pos);
+
+            for (size_t i = 0; i < n; i++)
+                put(pos + i, v[i]);
+
+            return n;
+        }
+
+        /**
+         * Moves out as many elements as are available, up to a maximum, with a single claim on the head.
+         *
+         * @param[out] v receives the elements, in order.
+         * @param count maximum number of elements.
+         * @return the number of elements dequeued, 0 if the queue is empty.
+         */
+        size_t trypopbulk(T *v, size_t count) throw()
+        {
+            size_t pos;
+            size_t n = claim(head, 1, count, pos);
+
+            for (size_t i = 0; i < n; i++)
+                take(pos + i, v[i]);
+
+            return n;
+        }
+
+        /**
+         * Moves an element into the queue, waiting for room.
+         * @param v the element.
+         */
+        void push(T &&v) throw()
+        {
+            for (unsigned spins = 0; !trypush(std::move(v)); )
+                backoff(spins);
+        }
+
+        /**
+         * Moves an element out of the queue, waiting for one.
+         * @param[out] v receives the element.
+         */
+        void pop(T &v) throw()
+        {
+            for (unsigned spins = 0; !trypop(v); )
+                backoff(spins);
+        }
+
+        /**
+         * Maximum number of elements.
+         * @return an unsigned integer.
+         */
+        size_t capacity() const throw()
+        {
+            return mask + 1;
+        }
+
+        /**
+         * Number of queued elements. Only a hint while other threads use the queue.
+         * @return an unsigned integer.
+         */
+        size_t sizehint() const throw()
+        {
+            size_t h = head.load(std::memory_order_relaxed);
+            size_t t = tail.load(std::memory_order_relaxed);
+
+            return t > h ? t - h : 0;
+        }
+
+        /**
+         * Waits a little longer on each call: yields at first, then sleeps for 50 microseconds, so that an idle
+         * thread doesn't keep a core busy.
+         *
+         * @param spins number of waits so far, start from 0 and reset it when the wait is over.
+         */
+        static void backoff(unsigned &spins) throw()
+        {
+            if (spins < 64)
+            {
+                spins++;
+                std::this_thread::yield();
+            }
+            else
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+
+    protected:
+        struct cell
+        {
+            std::atomic<size_t> seq; /**< pos when free for the producer of pos, pos + 1 when ready for its consumer */
+            typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type storage;
+        };
+
+        cell *cells;
+        size_t mask;
+        char pad0[64]; /**< Keeps the indexes on separate cache lines. */
+        std::atomic<size_t> head;
+        char pad1[64];
+        std::atomic<size_t> tail;
+        char pad2[64];
+
+        /**
+         * Claims up to count consecutive positions on one of the indexes.
+         * The cells of a claim are all ready, so nobody else can touch them until they are released.
+         *
+         * @param index head or tail.
+         * @param ready 0 when claiming free cells, 1 when claiming full ones.
+         * @param count maximum number of positions.
+         * @param[out] pos the first position claimed.
+         * @return the number of positions claimed.
+         */
+        size_t claim(std::atomic<size_t> &index, size_t ready, size_t count, size_t &pos) throw()
+        {
+            pos = index.load(std::memory_order_relaxed);
+
+            if (!count)
+                return 0;
+
+            for (;;)
+            {
+                size_t n = 0;
+                intptr_t dif = 0;
+
+                while (n < count && n <= mask)
+                {
+                    dif = static_cast<intptr_t>(cells[(pos + n) & mask].seq.load(std::memory_order_acquire) -
+                                                (pos + n + ready));
+
+                    if (dif)
+                        break;
+
+                    n++;
+                }
+
+                if (n)
+                {
+                    if (index.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed))
+                        return n;
+                }
+                else if (dif > 0)
+                    pos = index.load(std::memory_order_relaxed); // another thread got there first
+                else
+                    return 0; // full when pushing, empty when popping
+            }
+        }
+
+        void put(size_t pos, T &v) throw()
+        {
+            cell &c = cells[pos & mask];
+
+            new (&c.storage) T(std::move(v));
+            c.seq.store(pos + 1, std::memory_order_release);
+        }
+
+        void take(size_t pos, T &v) throw()
+        {
+            cell &c = cells[pos & mask];
+            T *p = reinterpret_cast<T *>(&c.storage);
+
+            v = std::move(*p);
+            p->~T();
+            c.seq.store(pos + mask + 1, std::memory_order_release);
+        }
+
+    private:
+        // non-copyable
+        ringqueue(const ringqueue &);
+        ringqueue &operator=(const ringqueue &);
+    };
+}
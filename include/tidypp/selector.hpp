@@ -0,0 +1,141 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "node.hpp"
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace tidypp
+{
+    /**
+     * A compiled CSS selector. Compile it once and reuse it on any number of documents: tag and attribute names
+     * are resolved to Tidy's tagid / attributeid at compile time, so matching a node mostly compares integers.<br />
+     * Supported syntax:
+     * @li type and universal selectors: div, *
+     * @li id and class selectors: #main, .article
+     * @li attribute selectors: [href], [rel=nofollow], [class~=a], [lang|=en], [href^=http], [src$=".png"],
+     *     [title*=news]
+     * @li pseudo-classes: :first-child, :last-child, :only-child
+     * @li combinators: descendant (space), child (>), adjacent sibling (+), general sibling (~)
+     * @li selector lists: h1, h2
+     *
+     * Example:
+     * @verbatim
+       tidypp::selector links("div.article > a[href]"); // compile once
+
+       // [...] for each document
+       std::vector<tidypp::node> found;
+       links.select(doc.root(), found);
+     * @endverbatim
+     *
+     * @see document::select()
+     */
+    class selector
+    {
+    public:
+        /**
+         * Compiles a selector.
+         *
+         * @param[in] text the selector, zero-terminated string.
+         * @throw tidypp::exception an exception that describes the syntax error.
+         */
+        selector(ctmbstr text) throw(const exception &);
+
+        /**
+         * Default destructor.
+         */
+        virtual ~selector() throw();
+
+        /**
+         * Checks if a node matches the selector.
+         *
+         * @param n the node.
+         * @return true if the node is an element matched by the selector, otherwise false.
+         */
+        bool matches(node &n) const throw();
+
+        /**
+         * Collects all the nodes below the given one that match the selector, in document order.
+         * The tree is walked once. A descendant or sibling combinator still walks the ancestors or previous
+         * siblings of each candidate, so the cost is O(nodes * depth) in the worst case, but the steps past the
+         * first one that are already known to fail from a node are not explored again.
+         *
+         * @param n the node where the search starts (not included in the results).
+         * @param[out] dst the matching nodes are appended here.
+         */
+        void select(node &n, std::vector<node> &dst) const;
+
+        /**
+         * Gets the source text of the selector.
+         * @return the selector as passed to the constructor.
+         */
+        const std::string &text() const throw();
+
+    protected:
+        /**
+         * A single attribute condition.
+         */
+        struct attrtest
+        {
+            attributeid id; /**< Resolved attribute id, TidyAttr_UNKNOWN to compare by name. */
+            std::string name; /**< Lowercase attribute name. */
+            char op; /**< 0 (exists), '=', '~', '|', '^', '$' or '*' */
+            std::string value;
+        };
+
+        /**
+         * A compound selector (e.g. a.external[href]) and the combinator that links it to the one on its left.
+         */
+        struct compound
+        {
+            tagid tag; /**< Resolved tag id, TidyTag_UNKNOWN to compare by name. */
+            std::string name; /**< Lowercase tag name, empty for the universal selector. */
+            std::vector<attrtest> attrs;
+            int pseudo; /**< Bitmask of pseudo-classes. */
+            char comb; /**< ' ', '>', '+' or '~', 0 for the leftmost compound */
+        };
+
+        typedef std::vector<compound> chain; /**< A complex selector, rightmost compound first. */
+
+        typedef std::pair<TidyNode, const compound *> step; /**< A node tried against a step of a chain. */
+
+        struct stephash
+        {
+            size_t operator()(const step &s) const throw();
+        };
+
+        typedef std::unordered_set<step, stephash> failset; /**< Steps known not to match. */
+
+        std::string src;
+        std::vector<chain> chains; /**< One for each selector in the list. */
+
+        void parse(ctmbstr text) throw(const exception &);
+        bool matches(TidyNode n, failset *failed) const throw();
+        bool matchchain(const chain &c, size_t k, TidyNode n, failset *failed = NULL) const throw();
+        static bool matchcompound(const compound &c, TidyNode n) throw();
+        static bool matchattr(const attrtest &t, TidyNode n) throw();
+
+        friend class queryset;
+    };
+}
@@ -0,0 +1,119 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "strview.hpp"
+#include <vector>
+
+namespace tidypp
+{
+    // forward declarations
+    class buffer;
+    class node;
+
+    /**
+     * Maps the line / column positions reported by Tidy back to byte offsets in the original input, so that the
+     * source text of a node can be viewed in place when the input is kept around (e.g. a memory-mapped file or
+     * the buffer given to document::parsebuffer()).<br />
+     * Building the map is a single memchr pass over the input; each lookup then scans one line at most.
+     * Columns are counted like Tidy does: tabs advance to the next tab stop and, for UTF-8 input, multi-byte
+     * sequences count as one column.<br /><br />
+     *
+     * Example:
+     * @verbatim
+       doc.parsebuffer(html);
+
+       tidypp::sourcemap map(html); // html must not change while the map is used
+       tidypp::strview src = map.source(mynode); // "<a href=...>...</a>" as it appears in the input
+     * @endverbatim
+     */
+    class sourcemap
+    {
+    public:
+        static const size_t npos = static_cast<size_t>(-1); /**< No such offset. */
+
+        /**
+         * Maps a chunk of memory.
+         *
+         * @param[in] data the input, it must outlive the map.
+         * @param size size of the input in bytes.
+         * @param tabsize tab width, as set with the TidyTabSize option.
+         * @param utf8 true if the input is UTF-8, false for single byte encodings.
+         */
+        sourcemap(const void *data, size_t size, uint tabsize = 8, bool utf8 = true);
+
+        /**
+         * Maps the content of a buffer. The buffer must not be modified while the map is used.
+         *
+         * @param buf the buffer.
+         * @param tabsize tab width, as set with the TidyTabSize option.
+         * @param utf8 true if the input is UTF-8, false for single byte encodings.
+         */
+        sourcemap(buffer &buf, uint tabsize = 8, bool utf8 = true);
+
+        /**
+         * Default destructor.
+         */
+        virtual ~sourcemap() throw();
+
+        /**
+         * Gets the whole input.
+         * @return the view of the input.
+         */
+        strview input() const throw();
+
+        /**
+         * Number of lines in the input.
+         * @return an unsigned integer.
+         */
+        size_t linecount() const throw();
+
+        /**
+         * Converts a Tidy position to a byte offset.
+         *
+         * @param line the line, starting from 1.
+         * @param column the column, starting from 1.
+         * @return the offset, or npos if the position is outside the input.
+         */
+        size_t offset(uint line, uint column) const throw();
+
+        /**
+         * Gets the source text of a node: from its position to the position of the node that follows it in
+         * document order (its next sibling, or the next sibling of the closest ancestor that has one), or to
+         * the end of the input. For elements this includes the end tag and the whitespace that follows it.<br />
+         * Nodes inferred or moved by Tidy, e.g. after document::cleanandrepair(), may not have a meaningful
+         * position: in that case the view is empty.
+         *
+         * @param n the node.
+         * @return the view of the source text.
+         */
+        strview source(node &n) const throw();
+
+    protected:
+        const char *p;
+        size_t len;
+        uint tabs;
+        bool utf8;
+        std::vector<size_t> lines; /**< Offset of the first byte of each line. */
+
+        void build();
+    };
+}
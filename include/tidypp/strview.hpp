@@ -0,0 +1,178 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "tidypp.hpp"
+#include <string.h>
+#include <string>
+
+namespace tidypp
+{
+    /**
+     * Non-owning view of a sequence of bytes, like C++17's std::string_view.<br />
+     * Returned by the *view() accessors so that values can be compared and hashed without measuring them
+     * again or copying them into a std::string. The viewed memory must outlive the view.
+     */
+    class strview
+    {
+    public:
+        typedef const char *iterator; /**< The iterator type. */
+
+        /**
+         * Default constructor. Creates an empty view.
+         */
+        strview() throw()
+            : p(""), len(0)
+        {
+            // empty
+        }
+
+        /**
+         * Views a zero-terminated string.
+         * @param[in] s the string, NULL is treated as empty.
+         */
+        strview(const char *s) throw()
+            : p(s ? s : ""), len(s ? strlen(s) : 0)
+        {
+            // empty
+        }
+
+        /**
+         * Views a sequence of bytes.
+         * @param[in] s pointer to the first byte.
+         * @param len number of bytes.
+         */
+        strview(const char *s, size_t len) throw()
+            : p(s), len(len)
+        {
+            // empty
+        }
+
+        /**
+         * Views the content of a std::string.
+         * @param[in] s the string.
+         */
+        strview(const std::string &s) throw()
+            : p(s.data()), len(s.size())
+        {
+            // empty
+        }
+
+        /**
+         * Pointer to the first byte. The view is not necessarily zero-terminated.
+         * @return the pointer.
+         */
+        const char *data() const throw()
+        {
+            return p;
+        }
+
+        /**
+         * Number of bytes in the view.
+         * @return an unsigned integer.
+         */
+        size_t size() const throw()
+        {
+            return len;
+        }
+
+        /**
+         * Checks if the view has no bytes.
+         * @return true if the view is empty, otherwise false.
+         */
+        bool empty() const throw()
+        {
+            return !len;
+        }
+
+        iterator begin() const throw()
+        {
+            return p;
+        }
+
+        iterator end() const throw()
+        {
+            return p + len;
+        }
+
+        char operator[](size_t i) const throw()
+        {
+            return p[i];
+        }
+
+        /**
+         * Gets a part of the view.
+         *
+         * @param pos offset of the first byte, clamped to size().
+         * @param n maximum number of bytes.
+         * @return the view of the part.
+         */
+        strview substr(size_t pos, size_t n = static_cast<size_t>(-1)) const throw()
+        {
+            if (pos > len)
+                pos = len;
+
+            return strview(p + pos, n < len - pos ? n : len - pos);
+        }
+
+        /**
+         * Checks if the view begins with the given bytes.
+         * @param other the prefix.
+         * @return true if other is a prefix of this view, otherwise false.
+         */
+        bool startswith(const strview &other) const throw()
+        {
+            return other.len <= len && !memcmp(p, other.p, other.len);
+        }
+
+        /**
+         * Copies the view into a std::string.
+         * @return the string.
+         */
+        std::string str() const
+        {
+            return std::string(p, len);
+        }
+
+        /**
+         * Hashes the view with fasthash().
+         * @return the hash.
+         */
+        hashvalue hash() const throw()
+        {
+            return fasthash(p, len);
+        }
+
+        bool operator==(const strview &other) const throw()
+        {
+            return len == other.len && !memcmp(p, other.p, len);
+        }
+
+        bool operator!=(const strview &other) const throw()
+        {
+            return !(*this == other);
+        }
+
+    protected:
+        const char *p;
+        size_t len;
+    };
+}
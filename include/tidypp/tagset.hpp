@@ -0,0 +1,184 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "tidypp.hpp"
+
+namespace tidypp
+{
+    /**
+     * A compile-time set of tag ids. Membership is a single shift and mask, so testing a node against many tags
+     * costs the same as testing it against one.<br /><br />
+     *
+     * Example:
+     * @verbatim
+       constexpr tidypp::tagset media(TidyTag_IMG, TidyTag_OBJECT, TidyTag_EMBED, TidyTag_APPLET);
+
+       if (mynode.in(media | tidypp::tags::headings))
+           // ...
+     * @endverbatim
+     *
+     * @see node::in()
+     * @see tags
+     */
+    class tagset
+    {
+    public:
+        /**
+         * Creates an empty set.
+         */
+        constexpr tagset() throw()
+            : w{ 0, 0, 0, 0 }
+        {
+            // empty
+        }
+
+        /**
+         * Creates a set containing the given tags.
+         * @param first the first tag.
+         * @param rest the other tags.
+         */
+        template <class... T>
+        constexpr tagset(tagid first, T... rest) throw()
+            : w{ bits(0, first, rest...), bits(1, first, rest...), bits(2, first, rest...), bits(3, first, rest...) }
+        {
+            // empty
+        }
+
+        /**
+         * Checks if a tag is in the set.
+         * @param id the tag id.
+         * @return true if the tag is in the set, otherwise false.
+         */
+        constexpr bool contains(tagid id) const throw()
+        {
+            return (w[static_cast<unsigned>(id) >> 6] >> (static_cast<unsigned>(id) & 63)) & 1;
+        }
+
+        /**
+         * Checks if the set has no tags.
+         * @return true if the set is empty, otherwise false.
+         */
+        constexpr bool empty() const throw()
+        {
+            return !(w[0] | w[1] | w[2] | w[3]);
+        }
+
+        /**
+         * Union of two sets.
+         * @param other the other set.
+         * @return a set with the tags of both sets.
+         */
+        constexpr tagset operator|(const tagset &other) const throw()
+        {
+            return tagset(w[0] | other.w[0], w[1] | other.w[1], w[2] | other.w[2], w[3] | other.w[3], 0);
+        }
+
+        /**
+         * Intersection of two sets.
+         * @param other the other set.
+         * @return a set with the tags that are in both sets.
+         */
+        constexpr tagset operator&(const tagset &other) const throw()
+        {
+            return tagset(w[0] & other.w[0], w[1] & other.w[1], w[2] & other.w[2], w[3] & other.w[3], 0);
+        }
+
+        /**
+         * Difference of two sets.
+         * @param other the other set.
+         * @return a set with the tags of this set that are not in the other one.
+         */
+        constexpr tagset operator-(const tagset &other) const throw()
+        {
+            return tagset(w[0] & ~other.w[0], w[1] & ~other.w[1], w[2] & ~other.w[2], w[3] & ~other.w[3], 0);
+        }
+
+        constexpr bool operator==(const tagset &other) const throw()
+        {
+            return w[0] == other.w[0] && w[1] == other.w[1] && w[2] == other.w[2] && w[3] == other.w[3];
+        }
+
+        constexpr bool operator!=(const tagset &other) const throw()
+        {
+            return !(*this == other);
+        }
+
+    protected:
+        static_assert(N_TIDY_TAGS <= 256, "tagset can only hold 256 tag ids");
+
+        uint64_t w[4]; /**< One bit per tag id. */
+
+        /**
+         * Internal constructor from raw words. The last parameter only tells it apart from the tag constructor.
+         */
+        constexpr tagset(uint64_t w0, uint64_t w1, uint64_t w2, uint64_t w3, int) throw()
+            : w{ w0, w1, w2, w3 }
+        {
+            // empty
+        }
+
+        static constexpr uint64_t bits(unsigned) throw()
+        {
+            return 0;
+        }
+
+        template <class... T>
+        static constexpr uint64_t bits(unsigned word, tagid first, T... rest) throw()
+        {
+            return (static_cast<unsigned>(first) >> 6 == word ? 1ULL << (static_cast<unsigned>(first) & 63) : 0) |
+                bits(word, rest...);
+        }
+    };
+
+    /**
+     * Predefined tag sets for the usual element classes. Only tags known to every Tidy release are listed, combine
+     * them with your own sets to cover more.
+     */
+    namespace tags
+    {
+        /** h1 to h6 */
+        constexpr tagset headings(TidyTag_H1, TidyTag_H2, TidyTag_H3, TidyTag_H4, TidyTag_H5, TidyTag_H6);
+
+        /** Lists and list items */
+        constexpr tagset lists(TidyTag_UL, TidyTag_OL, TidyTag_DL, TidyTag_DIR, TidyTag_MENU, TidyTag_LI,
+            TidyTag_DT, TidyTag_DD);
+
+        /** Tables and their parts */
+        constexpr tagset tables(TidyTag_TABLE, TidyTag_CAPTION, TidyTag_COLGROUP, TidyTag_COL, TidyTag_THEAD,
+            TidyTag_TBODY, TidyTag_TFOOT, TidyTag_TR, TidyTag_TD, TidyTag_TH);
+
+        /** Block level elements, headings, lists and tables included */
+        constexpr tagset blocks = headings | lists | tables | tagset(TidyTag_ADDRESS, TidyTag_BLOCKQUOTE,
+            TidyTag_CENTER, TidyTag_DIV, TidyTag_FIELDSET, TidyTag_FORM, TidyTag_HR, TidyTag_ISINDEX,
+            TidyTag_LISTING, TidyTag_NOFRAMES, TidyTag_NOSCRIPT, TidyTag_P, TidyTag_PLAINTEXT, TidyTag_PRE,
+            TidyTag_XMP, TidyTag_BODY, TidyTag_HTML, TidyTag_FRAMESET);
+
+        /** Inline (text level) elements */
+        constexpr tagset inlines(TidyTag_A, TidyTag_ABBR, TidyTag_ACRONYM, TidyTag_APPLET, TidyTag_B,
+            TidyTag_BASEFONT, TidyTag_BDO, TidyTag_BIG, TidyTag_BLINK, TidyTag_BR, TidyTag_BUTTON, TidyTag_CITE,
+            TidyTag_CODE, TidyTag_DEL, TidyTag_DFN, TidyTag_EM, TidyTag_EMBED, TidyTag_FONT, TidyTag_I,
+            TidyTag_IFRAME, TidyTag_IMG, TidyTag_INPUT, TidyTag_INS, TidyTag_KBD, TidyTag_LABEL, TidyTag_MAP,
+            TidyTag_NOBR, TidyTag_OBJECT, TidyTag_Q, TidyTag_S, TidyTag_SAMP, TidyTag_SELECT, TidyTag_SMALL,
+            TidyTag_SPACER, TidyTag_SPAN, TidyTag_STRIKE, TidyTag_STRONG, TidyTag_SUB, TidyTag_SUP,
+            TidyTag_TEXTAREA, TidyTag_TT, TidyTag_U, TidyTag_VAR, TidyTag_WBR);
+    }
+}
@@ -22,6 +22,8 @@
 
 #include <exception>
 #include <string>
+#include <stddef.h>
+#include <stdint.h>
 #include <tidy/tidy.h>
 
 /**
@@ -57,6 +59,44 @@ namespace tidypp
                               @see exception(std::string info) */
     };
 
+    /**
+     * Thrown when an operation is stopped because its deadline expired or it was cancelled.
+     * @see deadline
+     */
+    class timeout : public exception
+    {
+    public:
+        /**
+         * Default constructor.
+         * @param info information about the operation that was stopped.
+         */
+        timeout(std::string info) throw();
+
+        /**
+         * Default destructor
+         */
+        virtual ~timeout() throw();
+    };
+
+    /**
+     * Thrown when an input breaks one of the limits of a document.
+     * @see document::setlimits()
+     */
+    class limitexceeded : public exception
+    {
+    public:
+        /**
+         * Default constructor.
+         * @param info the limit that was exceeded.
+         */
+        limitexceeded(std::string info) throw();
+
+        /**
+         * Default destructor
+         */
+        virtual ~limitexceeded() throw();
+    };
+
     typedef TidyNodeType nodetype; /**< Node types:
                                         @li TidyNode_Root: Root
                                         @li TidyNode_DocType: DOCTYPE
@@ -101,9 +141,37 @@ namespace tidypp
                                               failed to recognize them.
                                               @see document::setoptioncallback() */
 
+    typedef uint64_t hashvalue; /**< A 64-bit hash value. Used as config fingerprint and as cache key.
+                                     @see hashbytes()
+                                     @see document::config_fingerprint() */
+
+    const hashvalue hashseed = 14695981039346656037ULL; /**< Initial value for hashbytes(). */
+
     /**
      * Get HTML Tidy Lib release date (version) for current library.
      * @return a zero-terminated string.
      */
     ctmbstr releasedate() throw();
+
+    /**
+     * Hashes a chunk of memory with 64-bit FNV-1a. The result does not depend on the platform, so it can be
+     * stored and compared across processes. Chain calls by passing the previous result as the seed.
+     *
+     * @param[in] data pointer to the data.
+     * @param size size of the data in bytes.
+     * @param seed hashseed for a new hash, or the result of a previous call to continue it.
+     * @return the hash value.
+     */
+    hashvalue hashbytes(const void *data, size_t size, hashvalue seed = hashseed) throw();
+
+    /**
+     * Hashes a chunk of memory with xxHash64. Reads 32 bytes per round, so it is much faster than hashbytes() on
+     * large inputs such as whole pages. Like hashbytes(), the result does not depend on the platform.
+     *
+     * @param[in] data pointer to the data.
+     * @param size size of the data in bytes.
+     * @param seed the hash seed.
+     * @return the hash value.
+     */
+    hashvalue fasthash(const void *data, size_t size, hashvalue seed = 0) throw();
 }
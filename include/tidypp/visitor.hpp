@@ -0,0 +1,168 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#pragma once
+
+#include "strview.hpp"
+
+namespace tidypp
+{
+    /**
+     * Receives the events of document::visit(), a streaming (SAX-like) walk of the document tree.<br />
+     * The walk hands out strviews and lightweight attribute lists that point straight into Tidy's tree: no
+     * node or attribute wrappers and no per-node buffers are created, so an analysis costs about as much as a
+     * hand-written traversal in C. Views are only valid during the callback that receives them.<br />
+     * Override the events you need, the default implementations do nothing.<br /><br />
+     *
+     * Example:
+     * @verbatim
+       class counter : public tidypp::visitor
+       {
+       public:
+           size_t links;
+
+           counter() : links(0) { }
+
+           bool on_start(tidypp::tagid id, tidypp::strview name, const attrlist &attrs)
+           {
+               if (id == TidyTag_A && !attrs.get(TidyAttr_HREF).empty())
+                   links++;
+
+               return id != TidyTag_SCRIPT; // don't descend into scripts
+           }
+       };
+
+       counter c;
+       doc.visit(c);
+     * @endverbatim
+     */
+    class visitor
+    {
+    public:
+        /**
+         * An attribute as seen by attrlist::iterator.
+         */
+        struct attr
+        {
+            attributeid id; /**< TidyAttr_UNKNOWN for attributes Tidy doesn't know. */
+            strview name;
+            strview value; /**< Empty if the attribute has no value. */
+        };
+
+        /**
+         * Read-only view of the attributes of the current element.
+         */
+        class attrlist
+        {
+            friend class document;
+
+        public:
+            /**
+             * Forward iterator over the attributes.
+             */
+            class iterator
+            {
+                friend class attrlist;
+
+            public:
+                attr operator*() const throw();
+                iterator &operator++() throw();
+                bool operator==(const iterator &other) const throw();
+                bool operator!=(const iterator &other) const throw();
+
+            protected:
+                TidyAttr cur;
+
+                iterator(TidyAttr first) throw();
+            };
+
+            iterator begin() const throw();
+            iterator end() const throw();
+
+            /**
+             * Checks if the element has no attributes.
+             * @return true if there are no attributes, otherwise false.
+             */
+            bool empty() const throw();
+
+            /**
+             * Checks if the element has an attribute.
+             * @param id the attribute id.
+             * @return true if the attribute is there, with or without a value.
+             */
+            bool has(attributeid id) const throw();
+
+            /**
+             * Gets the value of an attribute.
+             * @param id the attribute id.
+             * @return the value, empty if the attribute is missing or has no value.
+             */
+            strview get(attributeid id) const throw();
+
+            /**
+             * Gets the value of an attribute by name, ignoring case.
+             * @param name the attribute name.
+             * @return the value, empty if the attribute is missing or has no value.
+             * @see node::attr()
+             */
+            strview get(strview name) const throw();
+
+        protected:
+            TidyNode n;
+
+            attrlist(TidyNode n) throw();
+        };
+
+        /**
+         * Default destructor.
+         */
+        virtual ~visitor() throw();
+
+        /**
+         * Called when an element starts.
+         *
+         * @param id the tag id, TidyTag_UNKNOWN for tags Tidy doesn't know.
+         * @param name the tag name.
+         * @param attrs the attributes.
+         * @return false to skip the content of the element, on_end() is still called.
+         */
+        virtual bool on_start(tagid id, strview name, const attrlist &attrs);
+
+        /**
+         * Called when an element ends, also for empty elements.
+         *
+         * @param id the tag id.
+         * @param name the tag name.
+         */
+        virtual void on_end(tagid id, strview name);
+
+        /**
+         * Called for each text node, with its raw content.
+         * @param text the text.
+         */
+        virtual void on_text(strview text);
+
+        /**
+         * Called for each comment.
+         * @param text the content of the comment, without the delimiters.
+         */
+        virtual void on_comment(strview text);
+    };
+}
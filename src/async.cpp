@@ -0,0 +1,183 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#include "../include/tidypp/async.hpp"
+#include "../include/tidypp/document.hpp"
+#include "../include/tidypp/buffer.hpp"
+#include <memory>
+
+namespace tidypp
+{
+    namespace
+    {
+        // runs op on ex, then done with its outcome, on resume if given
+        void dispatch(std::function<void()> op, completion done, executor &ex, executor *resume)
+        {
+            ex.post([op, done, resume]
+            {
+                std::exception_ptr err;
+
+                try
+                {
+                    op();
+                }
+                catch (...)
+                {
+                    err = std::current_exception();
+                }
+
+                if (resume)
+                    resume->post(std::bind(done, err));
+                else
+                    done(err);
+            });
+        }
+
+        // same, with a promise for a completion
+        std::future<void> dispatch(std::function<void()> op, executor &ex)
+        {
+            std::shared_ptr<std::promise<void> > p = std::make_shared<std::promise<void> >();
+
+            dispatch(op, [p](std::exception_ptr err)
+            {
+                if (err)
+                    p->set_exception(err);
+                else
+                    p->set_value();
+            }, ex, NULL);
+
+            return p->get_future();
+        }
+    }
+
+    // executor methods
+    executor::~executor() throw()
+    {
+        // empty
+    }
+
+    // threadpool methods
+    threadpool::threadpool(size_t threads)
+        : stopping(false)
+    {
+        if (!threads)
+            threads = std::thread::hardware_concurrency();
+
+        if (!threads)
+            threads = 1;
+
+        for (size_t i = 0; i < threads; i++)
+            this->threads.push_back(std::thread(&threadpool::work, this));
+    }
+
+    threadpool::~threadpool() throw()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+
+        wake.notify_all();
+
+        for (size_t i = 0; i < threads.size(); i++)
+            threads[i].join();
+    }
+
+    void threadpool::post(task t)
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            tasks.push_back(t);
+        }
+
+        wake.notify_one();
+    }
+
+    size_t threadpool::size() const throw()
+    {
+        return threads.size();
+    }
+
+    void threadpool::work() throw()
+    {
+        for (;;)
+        {
+            task t;
+
+            {
+                std::unique_lock<std::mutex> guard(lock);
+
+                wake.wait(guard, [this] { return stopping || !tasks.empty(); });
+
+                if (tasks.empty())
+                    return; // stopping, and nothing left to run
+
+                t = tasks.front();
+                tasks.pop_front();
+            }
+
+            try
+            {
+                t();
+            }
+            catch (...)
+            {
+                // a task has no one to report to, keep the thread alive
+            }
+        }
+    }
+
+    // functions
+    executor &defaultexecutor()
+    {
+        static threadpool pool; // thread-safe initialization since C++11
+        return pool;
+    }
+
+    void async_parse(document &doc, buffer &buf, completion done, executor &ex, executor *resume)
+    {
+        dispatch([&doc, &buf] { doc.parsebuffer(buf); }, done, ex, resume);
+    }
+
+    std::future<void> async_parse(document &doc, buffer &buf, executor &ex)
+    {
+        return dispatch([&doc, &buf] { doc.parsebuffer(buf); }, ex);
+    }
+
+    void async_clean(document &doc, completion done, executor &ex, executor *resume)
+    {
+        dispatch([&doc] { doc.cleanandrepair(); }, done, ex, resume);
+    }
+
+    std::future<void> async_clean(document &doc, executor &ex)
+    {
+        return dispatch([&doc] { doc.cleanandrepair(); }, ex);
+    }
+
+    void async_save(document &doc, buffer &buf, completion done, executor &ex, executor *resume)
+    {
+        dispatch([&doc, &buf] { doc.savebuffer(buf); }, done, ex, resume);
+    }
+
+    std::future<void> async_save(document &doc, buffer &buf, executor &ex)
+    {
+        return dispatch([&doc, &buf] { doc.savebuffer(buf); }, ex);
+    }
+}
@@ -48,6 +48,16 @@ namespace tidypp
         return tidyAttrValue(data);
     }
 
+    strview attribute::nameview() throw()
+    {
+        return strview(tidyAttrName(data));
+    }
+
+    strview attribute::valueview() throw()
+    {
+        return strview(tidyAttrValue(data));
+    }
+
     attributeid attribute::id() throw()
     {
         return tidyAttrGetId(data);
@@ -58,4 +68,49 @@ namespace tidypp
     {
         // empty
     }
+
+    // node::attribute_iterator methods
+    node::attribute_iterator::attribute_iterator() throw()
+    {
+        // empty
+    }
+
+    node::attribute_iterator::attribute_iterator(const TidyAttr &first) throw()
+        : cur(first)
+    {
+        // empty
+    }
+
+    attribute &node::attribute_iterator::operator*() const throw()
+    {
+        return cur;
+    }
+
+    attribute *node::attribute_iterator::operator->() const throw()
+    {
+        return &cur;
+    }
+
+    node::attribute_iterator &node::attribute_iterator::operator++() throw()
+    {
+        cur.data = tidyAttrNext(cur.data);
+        return *this;
+    }
+
+    node::attribute_iterator node::attribute_iterator::operator++(int) throw()
+    {
+        attribute_iterator res(*this);
+        ++*this;
+        return res;
+    }
+
+    bool node::attribute_iterator::operator==(const attribute_iterator &other) const throw()
+    {
+        return cur.data == other.cur.data;
+    }
+
+    bool node::attribute_iterator::operator!=(const attribute_iterator &other) const throw()
+    {
+        return cur.data != other.cur.data;
+    }
 }
@@ -0,0 +1,456 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#include "../include/tidypp/batch.hpp"
+#include "../include/tidypp/document.hpp"
+#include "../include/tidypp/buffer.hpp"
+#include "../include/tidypp/inputsource.hpp"
+#include "../include/tidypp/deadline.hpp"
+#include "../include/tidypp/metrics.hpp"
+#include "internal.hpp"
+#include <sys/stat.h>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace tidypp
+{
+    using internal::clock;
+    using internal::elapsed;
+    using internal::readfile;
+    using internal::tolerant;
+
+    // batch::worker
+    struct batch::worker
+    {
+        mem::pool pool; /**< Declared first, everything below allocates from it. */
+        document doc;
+        buffer in; /**< Attached to the input of the current item. */
+        buffer out;
+        buffer errors; /**< Receives Tidy's report, cleared for each item. */
+        std::vector<byte> file; /**< Contents of the current input file. */
+
+        // work-stealing deque: the owner pops from the front, thieves take from the back
+        std::mutex lock;
+        std::deque<size_t> queue;
+        size_t steals;
+
+        worker() throw()
+            : doc(pool), out(pool), errors(pool), steals(0)
+        {
+            // empty
+        }
+
+        bool pop(size_t &index)
+        {
+            std::lock_guard<std::mutex> guard(lock);
+
+            if (queue.empty())
+                return false;
+
+            index = queue.front();
+            queue.pop_front();
+
+            return true;
+        }
+
+        bool steal(size_t &index)
+        {
+            std::lock_guard<std::mutex> guard(lock);
+
+            if (queue.empty())
+                return false;
+
+            index = queue.back();
+            queue.pop_back();
+
+            return true;
+        }
+    };
+
+    // batch::item methods
+    batch::item batch::item::file(const std::string &path)
+    {
+        item res;
+
+        res.path = path;
+        res.data = NULL;
+        res.size = 0;
+        res.source = NULL;
+
+        return res;
+    }
+
+    batch::item batch::item::memory(const void *data, size_t size)
+    {
+        item res;
+
+        res.data = data;
+        res.size = size;
+        res.source = NULL;
+
+        return res;
+    }
+
+    batch::item batch::item::fromsource(io::inputsource &source, size_t sizehint)
+    {
+        item res;
+
+        res.data = NULL;
+        res.size = sizehint;
+        res.source = &source;
+
+        return res;
+    }
+
+    // batch::result methods
+    batch::result::result() throw()
+        : ok(false), timedout(false), status(-1), errors(0), warnings(0), bytesin(0), bytesout(0), seconds(0)
+    {
+        // empty
+    }
+
+    // batch::summary methods
+    batch::summary::summary() throw()
+        : items(0), failed(0), bytesin(0), bytesout(0), seconds(0), threads(0), steals(0)
+    {
+        // empty
+    }
+
+    double batch::summary::throughput() const throw()
+    {
+        return seconds > 0 ? bytesin / seconds : 0;
+    }
+
+    // batch::config methods
+    batch::config::config() throw()
+        : threads(0), clean(true), diagnostics(false), output(output_save), largefirst(true), timeout(0),
+          registry(NULL)
+    {
+        // empty
+    }
+
+    // batch methods
+    batch::batch(const config &cfg)
+        : cfg(cfg)
+    {
+        // empty
+    }
+
+    batch::~batch() throw()
+    {
+        for (size_t i = 0; i < workers.size(); i++)
+            delete workers[i];
+    }
+
+    void batch::add(const item &it)
+    {
+        items.push_back(it);
+    }
+
+    size_t batch::size() const throw()
+    {
+        return items.size();
+    }
+
+    void batch::clear() throw()
+    {
+        items.clear();
+        res.clear();
+    }
+
+    const batch::summary &batch::run() throw(const exception &)
+    {
+        size_t threads = cfg.threads ? cfg.threads : std::thread::hardware_concurrency();
+
+        if (!threads)
+            threads = 1;
+
+        if (threads > items.size())
+            threads = items.size() ? items.size() : 1;
+
+        // workers are created on this thread so that configuration errors are thrown to the caller
+        while (workers.size() < threads)
+            workers.push_back(makeworker());
+
+        clock::time_point start = clock::now();
+        std::vector<std::thread> pool;
+
+        res.assign(items.size(), result());
+        schedule(threads);
+
+        for (size_t i = 1; i < threads; i++)
+            pool.push_back(std::thread(&batch::work, this, i, threads));
+
+        work(0, threads); // the calling thread is the first worker
+
+        for (size_t i = 0; i < pool.size(); i++)
+            pool[i].join();
+
+        sum = summary();
+        sum.items = items.size();
+        sum.threads = threads;
+        sum.seconds = elapsed(start);
+
+        for (size_t i = 0; i < threads; i++)
+            sum.steals += workers[i]->steals;
+
+        for (size_t i = 0; i < res.size(); i++)
+        {
+            sum.failed += !res[i].ok;
+            sum.bytesin += res[i].bytesin;
+            sum.bytesout += res[i].bytesout;
+        }
+
+        return sum;
+    }
+
+    const std::vector<batch::result> &batch::results() const throw()
+    {
+        return res;
+    }
+
+    const batch::summary &batch::totals() const throw()
+    {
+        return sum;
+    }
+
+    void batch::schedule(size_t threads)
+    {
+        std::vector<size_t> order(items.size());
+
+        for (size_t i = 0; i < order.size(); i++)
+            order[i] = i;
+
+        if (cfg.largefirst)
+        {
+            std::vector<size_t> sizes(items.size());
+
+            for (size_t i = 0; i < items.size(); i++)
+            {
+                struct stat st;
+
+                sizes[i] = items[i].size;
+
+                if (!items[i].path.empty() && !stat(items[i].path.c_str(), &st))
+                    sizes[i] = static_cast<size_t>(st.st_size);
+            }
+
+            std::stable_sort(order.begin(), order.end(), [&sizes](size_t a, size_t b)
+            {
+                return sizes[a] > sizes[b];
+            });
+        }
+
+        // deal round-robin, so every worker starts with one of the biggest items
+        for (size_t i = 0; i < threads; i++)
+        {
+            workers[i]->queue.clear();
+            workers[i]->steals = 0;
+        }
+
+        for (size_t i = 0; i < order.size(); i++)
+            workers[i % threads]->queue.push_back(order[i]);
+    }
+
+    void batch::work(size_t self, size_t threads) throw()
+    {
+        worker &w = *workers[self];
+        size_t index;
+
+        for (;;)
+        {
+            if (w.pop(index))
+            {
+                process(w, index);
+                continue;
+            }
+
+            // no new items appear during a run, so one empty sweep over the other deques means we're done
+            bool stolen = false;
+
+            for (size_t i = 1; i < threads && !stolen; i++)
+                stolen = workers[(self + i) % threads]->steal(index);
+
+            if (!stolen)
+                break;
+
+            w.steals++;
+            process(w, index);
+        }
+    }
+
+    void batch::process(worker &w, size_t index) throw()
+    {
+        const item &it = items[index];
+        result &r = res[index];
+        clock::time_point start = clock::now();
+        deadline dl(cfg.timeout > 0 ? start + std::chrono::duration_cast<clock::duration>(
+                        std::chrono::duration<double>(cfg.timeout)) : clock::time_point::max());
+        bool timed = cfg.timeout > 0;
+        bool attached = false;
+        bool parsed = false; // the input reached Tidy
+
+        w.errors.clear();
+        w.pool.resetpeak();
+
+        try
+        {
+            if (!it.path.empty() || it.data)
+            {
+                static byte empty = 0;
+                byte *data = &empty;
+                size_t size = it.size;
+
+                if (!it.path.empty())
+                {
+                    if (!readfile(it.path, w.file))
+                        throw exception("batch: failed to read " + it.path + ".");
+
+                    size = w.file.size();
+
+                    if (size)
+                        data = &w.file[0];
+                }
+                else if (size)
+                    data = static_cast<byte *>(const_cast<void *>(it.data));
+
+                r.bytesin = size;
+                w.in.attach(data, static_cast<uint>(size));
+                attached = parsed = true;
+
+                tolerant(w.doc, [&] {
+                    if (timed)
+                        w.doc.parsebuffer(w.in, dl);
+                    else
+                        w.doc.parsebuffer(w.in);
+                });
+            }
+            else if (it.source)
+            {
+                r.bytesin = it.size;
+                parsed = true;
+
+                tolerant(w.doc, [&] {
+                    if (timed)
+                        w.doc.parsesource(*it.source, dl);
+                    else
+                        w.doc.parsesource(*it.source);
+                });
+            }
+            else
+                throw exception("batch: empty item.");
+
+            if (cfg.clean)
+            {
+                tolerant(w.doc, [&] {
+                    if (timed)
+                        w.doc.cleanandrepair(dl);
+                    else
+                        w.doc.cleanandrepair();
+                });
+            }
+
+            if (cfg.diagnostics)
+                tolerant(w.doc, [&] { w.doc.rundiagnostics(); });
+
+            if (cfg.output == output_save)
+            {
+                // without force-output Tidy saves nothing for a document with errors
+                if (w.doc.status() == 2 && !w.doc.optgetbool(TidyForceOutput))
+                    throw exception("batch: the document has errors and force-output is not set.");
+
+                w.out.clear();
+                tolerant(w.doc, [&] { w.doc.savebuffer(w.out); });
+                r.output.assign(reinterpret_cast<const char *>(w.out.ptr()), w.out.size());
+            }
+            else if (cfg.output == output_text)
+                w.doc.extract_text(r.output);
+
+            r.ok = true;
+
+            if (cfg.process)
+                cfg.process(index, w.doc, r);
+        }
+        catch (const timeout &e)
+        {
+            r.ok = false;
+            r.timedout = true;
+            r.message = e.what();
+        }
+        catch (const std::exception &e)
+        {
+            r.ok = false;
+            r.message = e.what();
+        }
+        catch (...)
+        {
+            r.ok = false;
+            r.message = "batch: unknown exception.";
+        }
+
+        if (attached)
+            w.in.detach();
+
+        if (parsed)
+        {
+            r.status = w.doc.status();
+            r.errors = w.doc.errorcount();
+            r.warnings = w.doc.warningcount();
+
+            if (cfg.registry)
+            {
+                cfg.registry->record(w.doc, r.ok);
+                cfg.registry->recordpeak(w.pool.peak());
+            }
+        }
+
+        r.bytesout = r.output.size();
+        r.seconds = elapsed(start);
+    }
+
+    batch::worker *batch::makeworker() throw(const exception &)
+    {
+        worker *w = new worker;
+
+        try
+        {
+            w->doc.seterrorbuffer(w->errors);
+
+            if (!cfg.configfile.empty())
+                w->doc.loadconfig(cfg.configfile.c_str());
+
+            for (size_t i = 0; i < cfg.options.size(); i++)
+                w->doc.optparsevalue(cfg.options[i].first.c_str(), cfg.options[i].second.c_str());
+
+            if (cfg.setup)
+                cfg.setup(w->doc);
+        }
+        catch (...)
+        {
+            delete w;
+            throw;
+        }
+
+        return w;
+    }
+}
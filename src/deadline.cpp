@@ -0,0 +1,129 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#include "../include/tidypp/deadline.hpp"
+
+namespace tidypp
+{
+    // deadline methods
+    deadline::deadline() throw()
+        : at(clock::time_point::max()), stop(false)
+    {
+        // empty
+    }
+
+    deadline::deadline(double seconds) throw()
+        : at(clock::now() + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(seconds))),
+          stop(false)
+    {
+        // empty
+    }
+
+    deadline::deadline(clock::time_point at) throw()
+        : at(at), stop(false)
+    {
+        // empty
+    }
+
+    deadline::~deadline() throw()
+    {
+        // empty
+    }
+
+    void deadline::cancel() throw()
+    {
+        stop.store(true, std::memory_order_relaxed);
+    }
+
+    bool deadline::cancelled() const throw()
+    {
+        return stop.load(std::memory_order_relaxed);
+    }
+
+    bool deadline::expired() const throw()
+    {
+        return cancelled() || (at != clock::time_point::max() && clock::now() >= at);
+    }
+
+    double deadline::remaining() const throw()
+    {
+        if (cancelled())
+            return 0;
+
+        if (at == clock::time_point::max())
+            return std::chrono::duration<double>(clock::duration::max()).count();
+
+        double res = std::chrono::duration<double>(at - clock::now()).count();
+        return res > 0 ? res : 0;
+    }
+
+    namespace io
+    {
+        // deadlinesource methods
+        deadlinesource::deadlinesource(inputsource &inner, const deadline &dl) throw(const exception &)
+            : inputsource(this, sourcegetbyte, sourceungetbyte, sourceeof), inner(inner), dl(dl),
+              countdown(checkinterval), cut(false)
+        {
+            // empty
+        }
+
+        deadlinesource::~deadlinesource() throw()
+        {
+            // empty
+        }
+
+        bool deadlinesource::truncated() const throw()
+        {
+            return cut;
+        }
+
+        int TIDY_CALL deadlinesource::sourcegetbyte(void *srcdata)
+        {
+            deadlinesource *self = static_cast<deadlinesource *>(srcdata);
+
+            if (self->cut)
+                return EndOfStream;
+
+            if (!--self->countdown)
+            {
+                self->countdown = checkinterval;
+
+                if (self->dl.expired())
+                {
+                    self->cut = true;
+                    return EndOfStream;
+                }
+            }
+
+            return self->inner.getbyte();
+        }
+
+        void TIDY_CALL deadlinesource::sourceungetbyte(void *srcdata, byte bt)
+        {
+            static_cast<deadlinesource *>(srcdata)->inner.ungetbyte(bt);
+        }
+
+        Bool TIDY_CALL deadlinesource::sourceeof(void *srcdata)
+        {
+            deadlinesource *self = static_cast<deadlinesource *>(srcdata);
+            return self->cut || self->inner.eof() ? yes : no;
+        }
+    }
+}
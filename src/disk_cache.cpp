@@ -0,0 +1,394 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#include "../include/tidypp/disk_cache.hpp"
+#include <string.h>
+#include <errno.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace tidypp
+{
+    namespace
+    {
+        const char segmagic[8] = { 'T', 'I', 'D', 'Y', 'P', 'P', 'S', '1' };
+        const char idxmagic[8] = { 'T', 'I', 'D', 'Y', 'P', 'P', 'I', '2' };
+    }
+
+    // disk_cache::keyhash methods
+    size_t disk_cache::keyhash::operator()(const result_cache::key &k) const throw()
+    {
+        return static_cast<size_t>(k.content ^ (k.config * 0x9e3779b97f4a7c15ULL));
+    }
+
+#ifndef _WIN32
+    namespace
+    {
+        // write() until everything is written or an error occurs
+        bool writeall(int fd, const void *data, size_t size)
+        {
+            const byte *p = static_cast<const byte *>(data);
+
+            while (size)
+            {
+                ssize_t res = ::write(fd, p, size);
+
+                if (res < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+
+                    return false;
+                }
+
+                p += res;
+                size -= res;
+            }
+
+            return true;
+        }
+
+        // pwrite() until everything is written or an error occurs
+        bool pwriteall(int fd, const void *data, size_t size, uint64_t offset)
+        {
+            const byte *p = static_cast<const byte *>(data);
+
+            while (size)
+            {
+                ssize_t res = ::pwrite(fd, p, size, static_cast<off_t>(offset));
+
+                if (res < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+
+                    return false;
+                }
+
+                p += res;
+                size -= res;
+                offset += res;
+            }
+
+            return true;
+        }
+
+        // opens and locks a cache file, writing the magic if it is new and validating it otherwise.
+        // returns -2 if another process holds the lock
+        int openfile(const std::string &path, const char magic[8], uint64_t &size)
+        {
+            int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+            struct stat st;
+            char buf[8];
+
+            if (fd < 0)
+                return -1;
+
+            // the end of each file is only tracked in memory, a second writer would corrupt both
+            if (flock(fd, LOCK_EX | LOCK_NB) < 0)
+            {
+                ::close(fd);
+                return -2;
+            }
+
+            if (fstat(fd, &st) < 0)
+            {
+                ::close(fd);
+                return -1;
+            }
+
+            if (st.st_size < 8 || pread(fd, buf, 8, 0) != 8 || memcmp(buf, magic, 8))
+            {
+                // new or unrecognized file, start over
+                if (ftruncate(fd, 0) < 0 || pwrite(fd, magic, 8, 0) != 8)
+                {
+                    ::close(fd);
+                    return -1;
+                }
+
+                size = 8;
+            }
+            else
+                size = st.st_size;
+
+            return fd;
+        }
+    }
+
+    // disk_cache methods
+    disk_cache::disk_cache(const std::string &path) throw(const exception &)
+        : segfd(-1), idxfd(-1), segend(0), map(NULL), mapsize(0), nhits(0), nmisses(0)
+    {
+        uint64_t idxsize;
+
+        segfd = openfile(path + ".seg", segmagic, segend);
+        idxfd = openfile(path + ".idx", idxmagic, idxsize);
+
+        if (segfd == -2 || idxfd == -2)
+        {
+            close();
+            throw exception("disk_cache: cache files are in use by another process.");
+        }
+
+        if (segfd < 0 || idxfd < 0)
+        {
+            close();
+            throw exception("disk_cache: failed to open cache files.");
+        }
+
+        try
+        {
+            load();
+        }
+        catch (const exception &)
+        {
+            close();
+            throw;
+        }
+    }
+
+    disk_cache::~disk_cache() throw()
+    {
+        close();
+    }
+
+    bool disk_cache::find(const result_cache::key &k, result_cache::result &res)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        auto it = index.find(k);
+
+        if (it == index.end())
+        {
+            nmisses++;
+            return false;
+        }
+
+        const record &rec = it->second;
+
+        // the segment grows as results are inserted, extend the mapping lazily
+        if (rec.offset + rec.length > mapsize && !remap(segend))
+        {
+            nmisses++;
+            return false;
+        }
+
+        const byte *data = map + rec.offset;
+
+        // the index record may have reached the disk without the output it points to
+        if (fasthash(data, static_cast<size_t>(rec.length)) != rec.datahash)
+        {
+            index.erase(it);
+            nmisses++;
+            return false;
+        }
+
+        nhits++;
+        res.output.assign(reinterpret_cast<const char *>(data), static_cast<size_t>(rec.length));
+        res.status = rec.status;
+        res.errors = rec.errors;
+        res.warnings = rec.warnings;
+        res.accesswarnings = rec.accesswarnings;
+
+        return true;
+    }
+
+    void disk_cache::insert(const result_cache::key &k, const result_cache::result &res) throw(const exception &)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        record rec;
+
+        memset(&rec, 0, sizeof(record));
+        rec.content = k.content;
+        rec.config = k.config;
+        rec.size = k.size;
+        rec.offset = segend;
+        rec.length = res.output.size();
+        rec.status = res.status;
+        rec.errors = res.errors;
+        rec.warnings = res.warnings;
+        rec.accesswarnings = res.accesswarnings;
+        rec.datahash = fasthash(res.output.data(), res.output.size());
+        rec.check = checksum(rec);
+
+        // data first, then the index record that makes it visible
+        if (!pwriteall(segfd, res.output.data(), res.output.size(), segend))
+            throw exception("disk_cache.insert: failed to append to segment file.");
+
+        off_t idxend = lseek(idxfd, 0, SEEK_CUR);
+
+        if (idxend < 0)
+            throw exception("disk_cache.insert: failed to append to index file.");
+
+        if (!writeall(idxfd, &rec, sizeof(record)))
+        {
+            // drop the partial record, otherwise the next load stops there and loses every later insert
+            if (ftruncate(idxfd, idxend) == 0)
+                lseek(idxfd, idxend, SEEK_SET);
+
+            throw exception("disk_cache.insert: failed to append to index file.");
+        }
+
+        segend += rec.length;
+        index[k] = rec;
+    }
+
+    void disk_cache::sync() throw()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        fsync(segfd);
+        fsync(idxfd);
+    }
+
+    void disk_cache::load() throw(const exception &)
+    {
+        uint64_t segsize = segend;
+        uint64_t valid = 8;
+        record rec;
+
+        segend = 8;
+
+        if (lseek(idxfd, 8, SEEK_SET) < 0)
+            throw exception("disk_cache: failed to read index file.");
+
+        // sequential read of fixed size records, stop at the first torn or inconsistent one
+        while (::read(idxfd, &rec, sizeof(record)) == sizeof(record))
+        {
+            if (rec.check != checksum(rec) || rec.offset < 8 || rec.offset + rec.length > segsize)
+                break;
+
+            result_cache::key k;
+
+            k.content = rec.content;
+            k.config = rec.config;
+            k.size = static_cast<size_t>(rec.size);
+
+            index[k] = rec;
+            valid += sizeof(record);
+
+            if (rec.offset + rec.length > segend)
+                segend = rec.offset + rec.length;
+        }
+
+        // drop whatever follows the last good record so that appends start from a consistent state
+        if (ftruncate(idxfd, valid) < 0 || lseek(idxfd, valid, SEEK_SET) < 0 || ftruncate(segfd, segend) < 0)
+            throw exception("disk_cache: failed to recover cache files.");
+
+        remap(segend);
+    }
+
+    bool disk_cache::remap(uint64_t size) throw()
+    {
+        if (map)
+            munmap(const_cast<byte *>(map), static_cast<size_t>(mapsize));
+
+        map = NULL;
+        mapsize = 0;
+
+        void *p = mmap(NULL, static_cast<size_t>(size), PROT_READ, MAP_SHARED, segfd, 0);
+
+        if (p == MAP_FAILED)
+            return false;
+
+        map = static_cast<const byte *>(p);
+        mapsize = size;
+
+        return true;
+    }
+
+    void disk_cache::close() throw()
+    {
+        if (map)
+            munmap(const_cast<byte *>(map), static_cast<size_t>(mapsize));
+
+        if (segfd >= 0)
+            ::close(segfd);
+
+        if (idxfd >= 0)
+            ::close(idxfd);
+
+        map = NULL;
+        segfd = idxfd = -1;
+    }
+#else
+    // disk_cache methods
+    disk_cache::disk_cache(const std::string &path) throw(const exception &)
+        : segfd(-1), idxfd(-1), segend(0), map(NULL), mapsize(0), nhits(0), nmisses(0)
+    {
+        throw exception("disk_cache: not supported on this platform.");
+    }
+
+    disk_cache::~disk_cache() throw()
+    {
+        // empty
+    }
+
+    bool disk_cache::find(const result_cache::key &k, result_cache::result &res)
+    {
+        return false;
+    }
+
+    void disk_cache::insert(const result_cache::key &k, const result_cache::result &res) throw(const exception &)
+    {
+        // empty
+    }
+
+    void disk_cache::sync() throw()
+    {
+        // empty
+    }
+#endif
+
+    uint64_t disk_cache::hits()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return nhits;
+    }
+
+    uint64_t disk_cache::misses()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return nmisses;
+    }
+
+    size_t disk_cache::count()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return index.size();
+    }
+
+    uint64_t disk_cache::segmentsize()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return segend;
+    }
+
+    uint64_t disk_cache::checksum(const record &rec) throw()
+    {
+        return hashbytes(&rec, offsetof(record, check));
+    }
+}
@@ -23,22 +23,495 @@
 #include "../include/tidypp/outputsink.hpp"
 #include "../include/tidypp/buffer.hpp"
 #include "../include/tidypp/node.hpp"
+#include "../include/tidypp/flattree.hpp"
+#include "../include/tidypp/selector.hpp"
+#include "../include/tidypp/visitor.hpp"
+#include "../include/tidypp/attribute.hpp"
+#include "../include/tidypp/deadline.hpp"
+#include "../include/tidypp/names.hpp"
+#include <ctype.h>
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
 
 namespace tidypp
 {
+    // document::nodeindex
+    struct document::nodeindex
+    {
+        std::vector<node> bytag[N_TIDY_TAGS];
+        std::unordered_map<std::string, node> byid;
+    };
+
+    namespace
+    {
+        constexpr tagset preformatted(TidyTag_PRE, TidyTag_LISTING, TidyTag_XMP, TidyTag_PLAINTEXT,
+            TidyTag_TEXTAREA);
+
+        bool isspacechar(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+        }
+
+        // state of an extract_text() walk
+        struct textwriter
+        {
+            std::string &dst;
+            const document::textoptions &opts;
+            size_t start; /**< Where the extracted text begins in dst. */
+            size_t seplen;
+            bool space; /**< Whitespace seen since the last character written. */
+            int pre; /**< Depth of preformatted elements. */
+
+            textwriter(std::string &dst, const document::textoptions &opts)
+                : dst(dst), opts(opts), start(dst.size()), seplen(opts.separator ? strlen(opts.separator) : 0),
+                  space(false), pre(0)
+            {
+                // empty
+            }
+
+            // true at the beginning of the text or right after a separator
+            bool atblockstart() const
+            {
+                return dst.size() == start || (seplen && dst.size() - start >= seplen &&
+                    !dst.compare(dst.size() - seplen, seplen, opts.separator));
+            }
+
+            void separate()
+            {
+                space = false;
+
+                if (seplen && !atblockstart())
+                    dst.append(opts.separator, seplen);
+            }
+
+            // drops the separator left by the last block
+            void finish()
+            {
+                if (seplen && dst.size() - start >= seplen && atblockstart())
+                    dst.resize(dst.size() - seplen);
+            }
+
+            void text(const char *s, size_t len)
+            {
+                if (!opts.normalize || pre)
+                {
+                    if (space && !atblockstart())
+                        dst.push_back(' ');
+
+                    space = false;
+                    dst.append(s, len);
+                    return;
+                }
+
+                for (size_t i = 0; i < len; i++)
+                {
+                    if (isspacechar(s[i]))
+                        space = true;
+                    else
+                    {
+                        if (space && !atblockstart())
+                            dst.push_back(' ');
+
+                        space = false;
+                        dst.push_back(s[i]);
+                    }
+                }
+            }
+        };
+
+        // elements that never have content
+        constexpr tagset voids(TidyTag_AREA, TidyTag_BASE, TidyTag_BASEFONT, TidyTag_BGSOUND, TidyTag_BR,
+            TidyTag_COL, TidyTag_EMBED, TidyTag_FRAME, TidyTag_HR, TidyTag_IMG, TidyTag_INPUT, TidyTag_ISINDEX,
+            TidyTag_KEYGEN, TidyTag_LINK, TidyTag_META, TidyTag_NEXTID, TidyTag_PARAM, TidyTag_SPACER,
+            TidyTag_WBR);
+
+        // elements that Tidy closes when another one of the same kind starts (see samekind())
+        constexpr tagset nonesting(TidyTag_A, TidyTag_P, TidyTag_LI, TidyTag_DT, TidyTag_DD, TidyTag_TR,
+            TidyTag_TD, TidyTag_TH, TidyTag_THEAD, TidyTag_TBODY, TidyTag_TFOOT, TidyTag_COLGROUP, TidyTag_CAPTION,
+            TidyTag_OPTION, TidyTag_OPTGROUP, TidyTag_RB, TidyTag_RP, TidyTag_RT);
+
+        // a start tag of a closes an open b
+        bool samekind(tagid a, tagid b)
+        {
+            static constexpr tagset cells(TidyTag_TD, TidyTag_TH);
+            static constexpr tagset terms(TidyTag_DT, TidyTag_DD);
+            static constexpr tagset sections(TidyTag_THEAD, TidyTag_TBODY, TidyTag_TFOOT);
+            static constexpr tagset ruby(TidyTag_RB, TidyTag_RP, TidyTag_RT);
+
+            return a == b || (cells.contains(a) && cells.contains(b)) || (terms.contains(a) && terms.contains(b)) ||
+                (sections.contains(a) && sections.contains(b)) || (ruby.contains(a) && ruby.contains(b));
+        }
+
+        // elements whose content is not markup
+        constexpr tagset rawtext(TidyTag_SCRIPT, TidyTag_STYLE, TidyTag_TEXTAREA, TidyTag_TITLE, TidyTag_XMP);
+
+        const byte *skipto(const byte *p, const byte *end, byte c)
+        {
+            const byte *res = static_cast<const byte *>(memchr(p, c, end - p));
+            return res ? res : end;
+        }
+
+        // finds the end tag of a raw text element
+        const byte *skipraw(const byte *p, const byte *end, strview name)
+        {
+            for (; static_cast<size_t>(end - p) >= name.size() + 2; p++)
+            {
+                if (p[0] == '<' && p[1] == '/' &&
+                    !strncasecmp(reinterpret_cast<const char *>(p) + 2, name.data(), name.size()))
+                    return p;
+            }
+
+            return end;
+        }
+
+        /*
+         * Cheap lexical check of the raw markup, before Tidy builds a tree out of it. Attributes are counted and
+         * measured as written. The depth is an estimate: a stack of the open known elements, where an end tag
+         * closes everything opened after its element and a start tag closes an open element that can't contain
+         * another of its kind (a, p, li, td...), the way Tidy closes them implicitly. It can only be lower than
+         * the real depth, which is checked exactly on the tree afterwards.
+         */
+        void prescan(const byte *p, size_t size, const document::limits &lim) throw(const exception &)
+        {
+            const byte *end = p + size;
+            std::vector<tagid> open;
+
+            while (p < end && (p = skipto(p, end, '<')) < end)
+            {
+                if (++p == end)
+                    break;
+
+                if (end - p >= 3 && p[0] == '!' && p[1] == '-' && p[2] == '-')
+                {
+                    // comment, skip to -->
+                    for (p += 3; p < end && (p[0] != '>' || p[-1] != '-' || p[-2] != '-'); p++);
+                    continue;
+                }
+
+                if (*p == '!' || *p == '?')
+                {
+                    p = skipto(p, end, '>');
+                    continue;
+                }
+
+                bool close = *p == '/';
+
+                if (close)
+                    p++;
+
+                if (p == end || !isalpha(*p))
+                    continue;
+
+                const byte *name = p;
+
+                while (p < end && (isalnum(*p) || *p == ':' || *p == '-'))
+                    p++;
+
+                strview tag(reinterpret_cast<const char *>(name), p - name);
+                tagid id = lookuptag(tag);
+                bool counted = lim.maxdepth && id != TidyTag_UNKNOWN && !voids.contains(id);
+
+                if (close)
+                {
+                    // pops the element and whatever was left open inside it, ignores stray end tags
+                    for (size_t i = counted ? open.size() : 0; i; i--)
+                    {
+                        if (open[i - 1] == id)
+                        {
+                            open.resize(i - 1);
+                            break;
+                        }
+                    }
+
+                    p = skipto(p, end, '>');
+                    continue;
+                }
+
+                size_t attrs = 0;
+                bool selfclosing = false;
+
+                for (;;)
+                {
+                    for (; p < end && (isspacechar(*p) || *p == '/'); p++)
+                        selfclosing = *p == '/' || (selfclosing && isspacechar(*p));
+
+                    if (p == end || *p == '>')
+                        break;
+
+                    selfclosing = false;
+
+                    while (p < end && !isspacechar(*p) && *p != '=' && *p != '>' && *p != '/')
+                        p++;
+
+                    if (lim.maxattributes && ++attrs > lim.maxattributes)
+                        throw limitexceeded("document.parsebuffer: too many attributes on an element.");
+
+                    while (p < end && isspacechar(*p))
+                        p++;
+
+                    if (p == end || *p != '=')
+                        continue;
+
+                    for (p++; p < end && isspacechar(*p); p++);
+
+                    const byte *value = p;
+                    size_t len;
+
+                    if (p < end && (*p == '"' || *p == '\''))
+                    {
+                        value = ++p;
+                        p = skipto(p, end, p[-1]);
+                        len = p - value;
+
+                        if (p < end)
+                            p++;
+                    }
+                    else
+                    {
+                        while (p < end && !isspacechar(*p) && *p != '>')
+                            p++;
+
+                        len = p - value;
+                    }
+
+                    if (lim.maxattrlength && len > lim.maxattrlength)
+                        throw limitexceeded("document.parsebuffer: attribute value is too long.");
+                }
+
+                if (counted && !selfclosing)
+                {
+                    if (nonesting.contains(id))
+                    {
+                        for (size_t i = open.size(); i; i--)
+                        {
+                            if (samekind(id, open[i - 1]))
+                            {
+                                open.resize(i - 1);
+                                break;
+                            }
+                        }
+                    }
+
+                    open.push_back(id);
+
+                    if (open.size() > lim.maxdepth)
+                        throw limitexceeded("document.parsebuffer: elements are nested too deeply.");
+                }
+
+                if (rawtext.contains(id))
+                    p = skipraw(p, end, tag);
+            }
+        }
+
+        // counts the bytes read and reports the end of the input once a maximum size has been read
+        class limitsource : public io::inputsource
+        {
+        public:
+            limitsource(io::inputsource &inner, size_t max) throw(const exception &)
+                : io::inputsource(this, sourcegetbyte, sourceungetbyte, sourceeof), inner(inner), max(max),
+                  left(max), over(false)
+            {
+                // empty
+            }
+
+            bool exceeded() const throw()
+            {
+                return over;
+            }
+
+            size_t count() const throw()
+            {
+                return max - left;
+            }
+
+        private:
+            io::inputsource &inner;
+            size_t max;
+            size_t left;
+            bool over;
+
+            static int TIDY_CALL sourcegetbyte(void *srcdata)
+            {
+                limitsource *self = static_cast<limitsource *>(srcdata);
+
+                if (self->over)
+                    return EndOfStream;
+
+                uint c = self->inner.getbyte();
+
+                if (c == EndOfStream)
+                    return EndOfStream;
+
+                if (!self->left)
+                {
+                    self->over = true;
+                    return EndOfStream;
+                }
+
+                self->left--;
+                return c;
+            }
+
+            static void TIDY_CALL sourceungetbyte(void *srcdata, byte bt)
+            {
+                limitsource *self = static_cast<limitsource *>(srcdata);
+
+                self->left++;
+                self->inner.ungetbyte(bt);
+            }
+
+            static Bool TIDY_CALL sourceeof(void *srcdata)
+            {
+                limitsource *self = static_cast<limitsource *>(srcdata);
+                return self->over || self->inner.eof() ? yes : no;
+            }
+        };
+
+        // counts the bytes written to a sink
+        class countingsink : public io::outputsink
+        {
+        public:
+            countingsink(io::outputsink &inner) throw(const exception &)
+                : io::outputsink(this, sinkputbyte), inner(inner), written(0)
+            {
+                // empty
+            }
+
+            size_t count() const throw()
+            {
+                return written;
+            }
+
+        private:
+            io::outputsink &inner;
+            size_t written;
+
+            static void TIDY_CALL sinkputbyte(void *snkdata, byte bt)
+            {
+                countingsink *self = static_cast<countingsink *>(snkdata);
+
+                self->written++;
+                self->inner.putbyte(bt);
+            }
+        };
+
+#ifdef TIDYPP_NO_STATS
+        const bool recordstats = false;
+#else
+        const bool recordstats = true;
+#endif
+
+        // CPU time of the calling thread, in seconds
+        double threadcputime()
+        {
+#ifdef _WIN32
+            FILETIME created, exited, kernel, user;
+
+            if (!GetThreadTimes(GetCurrentThread(), &created, &exited, &kernel, &user))
+                return 0;
+
+            uint64_t k = static_cast<uint64_t>(kernel.dwHighDateTime) << 32 | kernel.dwLowDateTime;
+            uint64_t u = static_cast<uint64_t>(user.dwHighDateTime) << 32 | user.dwLowDateTime;
+
+            return (k + u) * 1e-7; // 100 ns units
+#else
+            timespec ts;
+
+            if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts))
+                return 0;
+
+            return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+        }
+
+        // adds the time spent in its scope to a phase, nothing at all when stats are compiled out
+        class phasetimer
+        {
+        public:
+            typedef std::chrono::steady_clock clock;
+
+            phasetimer(document::statistics::timing &t) throw()
+                : t(t)
+            {
+                if (recordstats)
+                {
+                    wall = clock::now();
+                    cpu = threadcputime();
+                }
+            }
+
+            ~phasetimer() throw()
+            {
+                if (recordstats)
+                {
+                    t.wall += std::chrono::duration<double>(clock::now() - wall).count();
+                    t.cpu += threadcputime() - cpu;
+                    t.calls++;
+                }
+            }
+
+        private:
+            document::statistics::timing &t;
+            clock::time_point wall;
+            double cpu;
+        };
+    }
+
+    // document::textoptions methods
+    document::textoptions::textoptions() throw()
+        : normalize(true), separator("\n"), blocks(tags::blocks), skip(TidyTag_SCRIPT, TidyTag_STYLE)
+    {
+        // empty
+    }
+
     // document methods
+    // document::statistics methods
+    document::statistics::timing::timing() throw()
+        : wall(0), cpu(0), calls(0)
+    {
+        // empty
+    }
+
+    document::statistics::statistics() throw()
+        : bytesin(0), bytesout(0), nodes(0)
+    {
+        // empty
+    }
+
+    // document::limits methods
+    document::limits::limits() throw()
+        : maxbytes(0), maxdepth(0), maxattributes(0), maxattrlength(0)
+    {
+        // empty
+    }
+
     document::document() throw()
+        : index(NULL), nodescounted(false), fingerprint(hashseed), fingerprinted(false)
     {
         data = tidyCreate();
     }
 
     document::document(mem::allocator &allocator) throw()
+        : index(NULL), nodescounted(false), fingerprint(hashseed), fingerprinted(false)
     {
         data = tidyCreateWithAllocator(&allocator);
     }
 
     document::~document() throw()
     {
+        invalidateindexes();
         tidyRelease(data);
     }
 
@@ -94,11 +567,13 @@ namespace tidypp
 
     void document::loadconfig(ctmbstr configfile) throw(const exception &)
     {
+        fingerprinted = false;
         attempt(tidyLoadConfig(data, configfile), "document.loadconfig(configfile): failed to load config file.");
     }
 
     void document::loadconfig(ctmbstr configfile, ctmbstr charenc) throw(const exception &)
     {
+        fingerprinted = false;
         attempt(tidyLoadConfigEnc(data, configfile, charenc), "document.loadconfig(configfile, charenc): failed to load config file.");
     }
 
@@ -109,16 +584,19 @@ namespace tidypp
 
     void document::setcharencoding(ctmbstr charenc) throw(const exception &)
     {
+        fingerprinted = false;
         attempt(tidySetCharEncoding(data, charenc), "document.setcharencoding: failed to set char encoding.");
     }
 
     void document::setincharencoding(ctmbstr charenc) throw(const exception &)
     {
+        fingerprinted = false;
         attempt(tidySetInCharEncoding(data, charenc), "document.setincharencoding: failed to set input char encoding.");
     }
 
     void document::setoutcharencoding(ctmbstr charenc) throw(const exception &)
     {
+        fingerprinted = false;
         attempt(tidySetOutCharEncoding(data, charenc), "document.setoutcharencoding: failed to set output char encoding.");
     }
 
@@ -146,7 +624,12 @@ namespace tidypp
 
     option document::getoption(ctmbstr optnam) throw()
     {
-        return option(tidyGetOptionByName(data, optnam));
+        optionid optid = option::getidbyname(optnam);
+
+        if (optid == N_TIDY_OPTIONS)
+            return option();
+
+        return option(tidyGetOption(data, optid));
     }
 
     ctmbstr document::optgetvalue(optionid optid) throw()
@@ -156,13 +639,26 @@ namespace tidypp
 
     void document::optsetvalue(optionid optid, ctmbstr val) throw(const exception &)
     {
+        fingerprinted = false;
         if (!tidyOptSetValue(data, optid, val))
             throw exception("document.optsetvalue: failed to set option value.");
     }
 
     void document::optparsevalue(ctmbstr optnam, ctmbstr val) throw(const exception &)
     {
-        if (!tidyOptParseValue(data, optnam, val))
+        optionid optid = option::getidbyname(optnam);
+        Bool res;
+
+        fingerprinted = false;
+
+        // tidyOptSetValue runs the same per-type parser, unknown names still go through Tidy so that the
+        // option callback gets a chance to handle them
+        if (optid != N_TIDY_OPTIONS)
+            res = tidyOptSetValue(data, optid, val);
+        else
+            res = tidyOptParseValue(data, optnam, val);
+
+        if (!res)
             throw exception("document.optparsevalue: failed to parse option value.");
     }
 
@@ -173,6 +669,7 @@ namespace tidypp
 
     void document::optsetint(optionid optid, ulong val) throw(const exception &)
     {
+        fingerprinted = false;
         if (!tidyOptSetInt(data, optid, val))
             throw exception("document.optsetint: failed to set option value.");
     }
@@ -184,18 +681,21 @@ namespace tidypp
 
     void document::optsetbool(optionid optid, bool val) throw(const exception &)
     {
+        fingerprinted = false;
         if (!tidyOptSetBool(data, optid, val ? yes : no))
             throw exception("document.optsetbool: failed to set option value.");
     }
 
     void document::optreset(optionid optid) throw(const exception &)
     {
+        fingerprinted = false;
         if (!tidyOptResetToDefault(data, optid))
             throw exception("document.optreset: failed to reset option value.");
     }
 
     void document::optresetall() throw(const exception &)
     {
+        fingerprinted = false;
         if (!tidyOptResetAllToDefault(data))
             throw exception("document.optresetall: failed to reset options.");
     }
@@ -208,6 +708,7 @@ namespace tidypp
 
     void document::optrestoresnapshot() throw(const exception &)
     {
+        fingerprinted = false;
         if (!tidyOptResetToSnapshot(data))
             throw exception("document.optrestoresnapshot: failed to restore options snapshot.");
     }
@@ -222,8 +723,67 @@ namespace tidypp
         return tidyOptDiffThanSnapshot(data);
     }
 
+    hashvalue document::config_fingerprint() throw()
+    {
+        if (fingerprinted)
+            return fingerprint;
+
+        hashvalue res = hashseed;
+
+        fingerprinted = true;
+
+        if (!optdiffthandefault())
+            return fingerprint = res;
+
+        iterator it = optionlist();
+
+        while (it)
+        {
+            option opt = nextoption(&it);
+            optionid optid = opt.id();
+            byte val[8];
+            ctmbstr str;
+            ctmbstr def;
+            ulong num;
+
+            switch (opt.type())
+            {
+            case TidyString:
+                str = optgetvalue(optid);
+                def = opt.defaultval();
+
+                if (str == def || (str && def && !strcmp(str, def)))
+                    continue;
+
+                res = hashbytes(opt.name(), strlen(opt.name()) + 1, res);
+
+                if (str)
+                    res = hashbytes(str, strlen(str) + 1, res);
+                break;
+
+            case TidyInteger:
+            case TidyBoolean:
+                num = opt.type() == TidyBoolean ? optgetbool(optid) : optgetint(optid);
+
+                if (num == (opt.type() == TidyBoolean ? opt.defaultbool() : opt.defaultint()))
+                    continue;
+
+                // fixed byte order so that the fingerprint is the same on every platform
+                for (int i = 0; i < 8; i++)
+                    val[i] = static_cast<byte>(static_cast<uint64_t>(num) >> (i * 8));
+
+                res = hashbytes(opt.name(), strlen(opt.name()) + 1, res);
+                res = hashbytes(val, sizeof(val), res);
+                break;
+            }
+        }
+
+        return fingerprint = res;
+    }
+
     void document::optcopyconfig(const document &other) throw(const exception &)
     {
+        fingerprinted = false;
         if (!tidyOptCopyConfig(data, other.data))
             throw exception("document.optcopyconfig: failed to copy config.");
     }
@@ -293,47 +853,264 @@ namespace tidypp
 
     void document::parsebuffer(buffer &buf) throw(const exception &)
     {
-        attempt(tidyParseBuffer(data, &buf.data), "document.parsebuffer: failed to parse buffer.");
+        st = statistics();
+        st.bytesin = buf.size();
+        nodescounted = false;
+        checkinput(buf);
+        invalidateindexes();
+
+        try
+        {
+            phasetimer timer(st.parse);
+            attempt(tidyParseBuffer(data, &buf.data), "document.parsebuffer: failed to parse buffer.");
+        }
+        catch (const exception &)
+        {
+            // errors in the markup throw too, and those are the pages the limits are for
+            checktree();
+            throw;
+        }
+
+        checktree();
     }
 
     void document::parsesource(io::inputsource &source) throw(const exception &)
     {
-        attempt(tidyParseSource(data, &source.data), "document.parsesource: failed to parse generic input source.");
+        limitsource limited(source, lim.maxbytes ? lim.maxbytes : SIZE_MAX);
+        io::inputsource *in = lim.maxbytes || recordstats ? &limited : &source;
+
+        st = statistics();
+        nodescounted = false;
+        invalidateindexes();
+
+        try
+        {
+            phasetimer timer(st.parse);
+            attempt(tidyParseSource(data, &in->data), "document.parsesource: failed to parse generic input source.");
+        }
+        catch (const exception &)
+        {
+            st.bytesin = limited.count();
+
+            if (limited.exceeded())
+                throw limitexceeded("document.parsesource: input is larger than the maximum size.");
+
+            checktree();
+            throw;
+        }
+
+        st.bytesin = limited.count();
+
+        if (limited.exceeded())
+            throw limitexceeded("document.parsesource: input is larger than the maximum size.");
+
+        checktree();
+    }
+
+    void document::parsebuffer(buffer &buf, const deadline &dl) throw(const exception &)
+    {
+        checkinput(buf);
+
+        io::inputsource src(buf);
+        parsesource(src, dl);
+    }
+
+    void document::setlimits(const limits &lim) throw()
+    {
+        this->lim = lim;
+    }
+
+    const document::limits &document::getlimits() const throw()
+    {
+        return lim;
+    }
+
+    const document::statistics &document::stats()
+    {
+        if (nodescounted)
+            return st;
+
+        TidyNode root = tidyGetRoot(data);
+        TidyNode n = root ? tidyGetChild(root) : NULL;
+
+        st.nodes = 0;
+
+        while (n)
+        {
+            st.nodes++;
+
+            // preorder step: down to the first child, otherwise to the next sibling of the closest ancestor
+            TidyNode next = tidyGetChild(n);
+
+            if (next)
+            {
+                n = next;
+                continue;
+            }
+
+            while (n != root && !(next = tidyGetNext(n)))
+                n = tidyGetParent(n);
+
+            n = n == root ? NULL : next;
+        }
+
+        nodescounted = true;
+
+        return st;
+    }
+
+    void document::checkinput(buffer &buf) const throw(const exception &)
+    {
+        if (lim.maxbytes && buf.size() > lim.maxbytes)
+            throw limitexceeded("document.parsebuffer: input is larger than the maximum size.");
+
+        if (lim.maxdepth || lim.maxattributes || lim.maxattrlength)
+            prescan(buf.ptr(), buf.size(), lim);
+    }
+
+    void document::checktree() throw(const exception &)
+    {
+        if (!lim.maxdepth && !lim.maxattributes && !lim.maxattrlength)
+            return;
+
+        TidyNode root = tidyGetRoot(data);
+        size_t depth = 0;
+
+        for (TidyNode n = root ? tidyGetChild(root) : NULL; n; )
+        {
+            nodetype type = tidyNodeGetType(n);
+            TidyNode next = NULL;
+
+            if (type == TidyNode_Start || type == TidyNode_StartEnd)
+            {
+                size_t attrs = 0;
+
+                if (lim.maxdepth && ++depth > lim.maxdepth)
+                    throw limitexceeded("document: elements are nested too deeply.");
+
+                for (TidyAttr a = tidyAttrFirst(n); a; a = tidyAttrNext(a))
+                {
+                    ctmbstr value = tidyAttrValue(a);
+
+                    if (lim.maxattributes && ++attrs > lim.maxattributes)
+                        throw limitexceeded("document: too many attributes on an element.");
+
+                    if (lim.maxattrlength && value && strlen(value) > lim.maxattrlength)
+                        throw limitexceeded("document: attribute value is too long.");
+                }
+
+                if (!(next = tidyGetChild(n)))
+                    depth--;
+            }
+
+            if (next)
+            {
+                n = next;
+                continue;
+            }
+
+            // leave n and every ancestor that has no next sibling
+            while (n && !(next = tidyGetNext(n)))
+            {
+                n = tidyGetParent(n);
+
+                if (n == root)
+                    n = NULL;
+                else
+                    depth--;
+            }
+
+            n = next;
+        }
+    }
+
+    void document::parsesource(io::inputsource &source, const deadline &dl) throw(const exception &)
+    {
+        if (dl.expired())
+            throw timeout("document.parsesource: deadline expired.");
+
+        io::deadlinesource src(source, dl);
+
+        try
+        {
+            parsesource(src);
+        }
+        catch (const exception &)
+        {
+            // a truncated input usually comes with errors, report the cause instead
+            if (src.truncated())
+                throw timeout("document.parsesource: deadline expired.");
+
+            throw;
+        }
+
+        if (src.truncated())
+            throw timeout("document.parsesource: deadline expired.");
     }
 
     void document::cleanandrepair() throw(const exception &)
     {
+        phasetimer timer(st.clean);
+
+        invalidateindexes();
+        nodescounted = false;
         attempt(tidyCleanAndRepair(data), "document.cleanandrepair: failed to execute configured cleanup and repair operations.");
     }
 
+    void document::cleanandrepair(const deadline &dl) throw(const exception &)
+    {
+        if (dl.expired())
+            throw timeout("document.cleanandrepair: deadline expired.");
+
+        cleanandrepair();
+    }
+
     void document::rundiagnostics() throw(const exception &)
     {
+        phasetimer timer(st.diagnostics);
         attempt(tidyRunDiagnostics(data), "document.rundiagnostics: failed to run configured diagnostics on parsed and repaired markup.");
     }
 
     void document::savefile(ctmbstr filename) throw(const exception &)
     {
+        phasetimer timer(st.save);
         attempt(tidySaveFile(data, filename), "document.savefile: failed to save to named file.");
     }
 
     void document::savestdout() throw(const exception &)
     {
+        phasetimer timer(st.save);
         attempt(tidySaveStdout(data), "document.savestdout: failed to save to stdout.");
     }
 
     void document::savebuffer(buffer &buf) throw(const exception &)
     {
+        phasetimer timer(st.save);
+        size_t size = buf.size();
+
         attempt(tidySaveBuffer(data, &buf.data), "document.savebuffer: failed to save to buffer.");
+        st.bytesout += buf.size() - size;
     }
 
     int document::savestring(tmbstr buffer, uint *buflen) throw()
     {
-        return tidySaveString(data, buffer, buflen);
+        phasetimer timer(st.save);
+        int res = tidySaveString(data, buffer, buflen);
+
+        if (res >= 0 && res != ENOMEM && buflen)
+            st.bytesout += *buflen;
+
+        return res;
     }
 
     void document::savesink(io::outputsink &sink) throw(const exception &)
     {
-        attempt(tidySaveSink(data, &sink.data), "document.savesink: failed to save to given output sink.");
+        phasetimer timer(st.save);
+        countingsink counted(sink);
+        io::outputsink *out = recordstats ? &counted : &sink;
+
+        attempt(tidySaveSink(data, &out->data), "document.savesink: failed to save to given output sink.");
+        st.bytesout += counted.count();
     }
 
     void document::optsavefile(ctmbstr filename) throw(const exception &)
@@ -397,4 +1174,347 @@ namespace tidypp
         if (!tidyNodeGetValue(data, node.data, &buf.data))
             throw exception("document.nodegetvalue: failed to retrieve node value.");
     }
+
+    void document::flatten(flattree &tree, bool text)
+    {
+        TidyNode root = tidyGetRoot(data);
+        flattree::strref tagnames[N_TIDY_TAGS];
+        bool named[N_TIDY_TAGS] = { false };
+        TidyBuffer value;
+
+        tree.clear();
+
+        if (!root)
+        {
+            tree.attrfirst.push_back(0);
+            return;
+        }
+
+        if (text)
+            tidyBufInit(&value);
+
+        TidyNode n = root;
+        flattree::index parent = flattree::npos;
+        flattree::index prev = flattree::npos; // previous sibling of the node being added
+
+        while (n)
+        {
+            flattree::index i = tree.size();
+            tagid id = tidyNodeGetId(n);
+            nodetype type = tidyNodeGetType(n);
+
+            tree.tags.push_back(id);
+            tree.types.push_back(type);
+            tree.parents.push_back(parent);
+            tree.firstchildren.push_back(flattree::npos);
+            tree.nextsiblings.push_back(flattree::npos);
+            tree.lines.push_back(tidyNodeLine(n));
+            tree.columns.push_back(tidyNodeColumn(n));
+            tree.attrfirst.push_back(static_cast<flattree::index>(tree.attrids.size()));
+
+            if (prev != flattree::npos)
+                tree.nextsiblings[prev] = i;
+            else if (parent != flattree::npos)
+                tree.firstchildren[parent] = i;
+
+            // known tags share one copy of their name
+            if (id != TidyTag_UNKNOWN && id < N_TIDY_TAGS && named[id])
+                tree.names.push_back(tagnames[id]);
+            else
+            {
+                ctmbstr name = tidyNodeGetName(n);
+                flattree::strref ref = tree.addstr(name, name ? strlen(name) : 0);
+
+                tree.names.push_back(ref);
+
+                if (id != TidyTag_UNKNOWN && id < N_TIDY_TAGS)
+                {
+                    tagnames[id] = ref;
+                    named[id] = true;
+                }
+            }
+
+            for (TidyAttr a = tidyAttrFirst(n); a; a = tidyAttrNext(a))
+            {
+                ctmbstr name = tidyAttrName(a);
+                ctmbstr val = tidyAttrValue(a);
+
+                tree.attrids.push_back(tidyAttrGetId(a));
+                tree.attrnames.push_back(tree.addstr(name, name ? strlen(name) : 0));
+                tree.attrvalues.push_back(tree.addstr(val, val ? strlen(val) : 0));
+            }
+
+            if (text && type == TidyNode_Text)
+            {
+                tidyBufClear(&value);
+                tidyNodeGetValue(data, n, &value);
+                tree.texts.push_back(tree.addstr(reinterpret_cast<const char *>(value.bp), value.size));
+            }
+            else
+                tree.texts.push_back(flattree::strref());
+
+            // preorder step: down to the first child, otherwise to the next sibling of the closest ancestor
+            TidyNode next = tidyGetChild(n);
+
+            if (next)
+            {
+                parent = i;
+                prev = flattree::npos;
+                n = next;
+                continue;
+            }
+
+            prev = i;
+
+            while (n != root && !(next = tidyGetNext(n)))
+            {
+                n = tidyGetParent(n);
+                prev = parent;
+                parent = tree.parents[parent];
+            }
+
+            n = n == root ? NULL : next;
+        }
+
+        tree.attrfirst.push_back(static_cast<flattree::index>(tree.attrids.size()));
+
+        if (text)
+            tidyBufFree(&value);
+    }
+
+    std::vector<node> document::select(ctmbstr text) throw(const exception &)
+    {
+        return select(selector(text));
+    }
+
+    std::vector<node> document::select(const selector &sel)
+    {
+        std::vector<node> res;
+        node r = root();
+
+        sel.select(r, res);
+        return res;
+    }
+
+    const std::vector<node> &document::nodesbytag(tagid tag)
+    {
+        static const std::vector<node> none;
+        nodeindex &idx = getindex();
+
+        return tag < N_TIDY_TAGS ? idx.bytag[tag] : none;
+    }
+
+    node document::nodebyid(ctmbstr id)
+    {
+        nodeindex &idx = getindex();
+        auto it = idx.byid.find(id ? id : "");
+
+        return it != idx.byid.end() ? it->second : node();
+    }
+
+    void document::invalidateindexes() throw()
+    {
+        delete index;
+        index = NULL;
+    }
+
+    document::nodeindex &document::getindex()
+    {
+        if (index)
+            return *index;
+
+        std::unique_ptr<nodeindex> idx(new nodeindex);
+
+        for (node &n : root().descendants())
+        {
+            nodetype type = n.type();
+
+            if (type != TidyNode_Start && type != TidyNode_StartEnd)
+                continue;
+
+            tagid tag = n.id();
+
+            if (tag < N_TIDY_TAGS)
+                idx->bytag[tag].push_back(n);
+
+            attribute id = n.attrgetbyid(TidyAttr_ID);
+            ctmbstr value = id.valid() ? id.value() : NULL;
+
+            // the first element wins, like getElementById()
+            if (value)
+                idx->byid.insert(std::make_pair(std::string(value), n));
+        }
+
+        index = idx.release();
+        return *index;
+    }
+
+    void document::extract_text(std::string &dst, const textoptions &opts)
+    {
+        TidyNode root = tidyGetRoot(data);
+        textwriter out(dst, opts);
+        TidyBuffer value;
+
+        if (!root)
+            return;
+
+        tidyBufInit(&value);
+
+        for (TidyNode n = root; n; )
+        {
+            nodetype type = tidyNodeGetType(n);
+            tagid id = tidyNodeGetId(n);
+            bool element = type == TidyNode_Start || type == TidyNode_StartEnd;
+            TidyNode next = NULL;
+
+            if (type == TidyNode_Text)
+            {
+                tidyBufClear(&value);
+
+                if (tidyNodeGetValue(data, n, &value))
+                    out.text(reinterpret_cast<const char *>(value.bp), value.size);
+            }
+            else if (type == TidyNode_Root)
+                next = tidyGetChild(n);
+            else if (element && !opts.skip.contains(id))
+            {
+                if (opts.blocks.contains(id) || id == TidyTag_BR)
+                    out.separate();
+
+                if (preformatted.contains(id))
+                    out.pre++;
+
+                next = tidyGetChild(n);
+            }
+
+            if (next)
+            {
+                n = next;
+                continue;
+            }
+
+            // leave n and every ancestor that has no next sibling
+            for (;;)
+            {
+                type = tidyNodeGetType(n);
+                id = tidyNodeGetId(n);
+
+                if ((type == TidyNode_Start || type == TidyNode_StartEnd) && !opts.skip.contains(id))
+                {
+                    if (opts.blocks.contains(id))
+                        out.separate();
+
+                    if (preformatted.contains(id))
+                        out.pre--;
+                }
+
+                if (n == root)
+                {
+                    n = NULL;
+                    break;
+                }
+
+                if ((next = tidyGetNext(n)))
+                {
+                    n = next;
+                    break;
+                }
+
+                n = tidyGetParent(n);
+            }
+        }
+
+        out.finish();
+        tidyBufFree(&value);
+    }
+
+    void document::visit(visitor &v)
+    {
+        TidyNode root = tidyGetRoot(data);
+        TidyBuffer value;
+
+        if (!root)
+            return;
+
+        tidyBufInit(&value);
+
+        // the callbacks may throw, don't leak the scratch buffer
+        try
+        {
+            for (TidyNode n = root; n; )
+            {
+                nodetype type = tidyNodeGetType(n);
+                TidyNode next = NULL;
+
+                switch (type)
+                {
+                case TidyNode_Root:
+                    next = tidyGetChild(n);
+                    break;
+
+                case TidyNode_Start:
+                case TidyNode_StartEnd:
+                    if (v.on_start(tidyNodeGetId(n), strview(tidyNodeGetName(n)), visitor::attrlist(n)))
+                        next = tidyGetChild(n);
+
+                    break;
+
+                case TidyNode_Text:
+                case TidyNode_Comment:
+                    tidyBufClear(&value);
+
+                    if (tidyNodeGetValue(data, n, &value))
+                    {
+                        strview text(reinterpret_cast<const char *>(value.bp), value.size);
+
+                        if (type == TidyNode_Text)
+                            v.on_text(text);
+                        else
+                            v.on_comment(text);
+                    }
+
+                    break;
+
+                default:
+                    break;
+                }
+
+                if (next)
+                {
+                    n = next;
+                    continue;
+                }
+
+                // end n and every ancestor that has no next sibling
+                for (;;)
+                {
+                    type = tidyNodeGetType(n);
+
+                    if (type == TidyNode_Start || type == TidyNode_StartEnd)
+                        v.on_end(tidyNodeGetId(n), strview(tidyNodeGetName(n)));
+
+                    if (n == root)
+                    {
+                        n = NULL;
+                        break;
+                    }
+
+                    if ((next = tidyGetNext(n)))
+                    {
+                        n = next;
+                        break;
+                    }
+
+                    n = tidyGetParent(n);
+                }
+            }
+        }
+        catch (...)
+        {
+            tidyBufFree(&value);
+            throw;
+        }
+
+        tidyBufFree(&value);
+    }
 }
@@ -0,0 +1,76 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#include "../include/tidypp/flattree.hpp"
+
+namespace tidypp
+{
+    const flattree::index flattree::npos;
+
+    // flattree methods
+    flattree::index flattree::size() const throw()
+    {
+        return static_cast<index>(tags.size());
+    }
+
+    void flattree::clear() throw()
+    {
+        tags.clear();
+        types.clear();
+        parents.clear();
+        firstchildren.clear();
+        nextsiblings.clear();
+        lines.clear();
+        columns.clear();
+        names.clear();
+        texts.clear();
+        attrfirst.clear();
+        attrids.clear();
+        attrnames.clear();
+        attrvalues.clear();
+        arena.clear();
+    }
+
+    const char *flattree::str(const strref &ref) const throw()
+    {
+        return ref.length ? arena.c_str() + ref.offset : "";
+    }
+
+    flattree::strref flattree::addstr(const char *s, size_t len)
+    {
+        strref res;
+
+        // offset 0 always holds the empty string, shared by every empty reference
+        if (arena.empty())
+            arena.push_back('\0');
+
+        res.offset = 0;
+        res.length = static_cast<uint32_t>(len);
+
+        if (!len)
+            return res;
+
+        res.offset = static_cast<uint32_t>(arena.size());
+        arena.append(s, len);
+        arena.push_back('\0');
+
+        return res;
+    }
+}
@@ -20,6 +20,7 @@
 
 #include "../include/tidypp/inputsource.hpp"
 #include "../include/tidypp/buffer.hpp"
+#include <string.h>
 
 namespace tidypp
 {
@@ -28,12 +29,14 @@ namespace tidypp
         // inputsource methods
         inputsource::inputsource(void *srcdata, getbytefunc gbfunc, ungetbytefunc ugbfunc, eoffunc endfunc)
             throw(const exception &)
+            : direct(NULL)
         {
             if (!tidyInitSource(&data, srcdata, gbfunc, ugbfunc, endfunc))
                 throw exception("inputsource: failed to initialize input source.");
         }
 
         inputsource::inputsource(buffer &buf) throw()
+            : direct(&buf.data)
         {
             tidyInitInputBuffer(&data, &buf.data);
         }
@@ -57,5 +60,30 @@ namespace tidypp
         {
             return tidyIsEOF(&data);
         }
+
+        size_t inputsource::read(byte *dst, size_t size) throw()
+        {
+            size_t n = 0;
+
+            if (direct)
+            {
+                n = direct->next < direct->size ? direct->size - direct->next : 0;
+
+                if (n > size)
+                    n = size;
+
+                if (n)
+                    memcpy(dst, direct->bp + direct->next, n);
+
+                direct->next += static_cast<uint>(n);
+
+                return n;
+            }
+
+            for (uint c; n < size && !eof() && (c = getbyte()) != EndOfStream; )
+                dst[n++] = static_cast<byte>(c);
+
+            return n;
+        }
     }
 }
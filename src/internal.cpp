@@ -0,0 +1,77 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+#include "internal.hpp"
+#include "../include/tidypp/inputsource.hpp"
+#include <stdio.h>
+
+namespace tidypp
+{
+    namespace internal
+    {
+        double elapsed(clock::time_point start)
+        {
+            return std::chrono::duration<double>(clock::now() - start).count();
+        }
+
+        bool readfile(const std::string &path, std::vector<byte> &dst)
+        {
+            FILE *f = fopen(path.c_str(), "rb");
+            long size;
+
+            if (!f)
+                return false;
+
+            if (fseek(f, 0, SEEK_END) || (size = ftell(f)) < 0 || fseek(f, 0, SEEK_SET))
+            {
+                fclose(f);
+                return false;
+            }
+
+            dst.resize(static_cast<size_t>(size));
+
+            bool ok = !size || fread(&dst[0], 1, dst.size(), f) == dst.size();
+
+            fclose(f);
+            return ok;
+        }
+
+        void readsource(io::inputsource &source, std::vector<byte> &dst)
+        {
+            const size_t block = 64 * 1024;
+            size_t used = 0;
+
+            dst.clear();
+
+            for (;;)
+            {
+                dst.resize(used + block);
+
+                size_t n = source.read(&dst[used], block);
+
+                used += n;
+
+                if (n < block)
+                    break;
+            }
+
+            dst.resize(used);
+        }
+    }
+}
@@ -0,0 +1,84 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+#pragma once
+
+#include "../include/tidypp/document.hpp"
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace tidypp
+{
+    namespace io
+    {
+        class inputsource;
+    }
+
+    /**
+     * Helpers shared by batch and pipeline. Not installed.
+     */
+    namespace internal
+    {
+        typedef std::chrono::steady_clock clock;
+
+        /**
+         * Seconds elapsed since a point in time.
+         */
+        double elapsed(clock::time_point start);
+
+        /**
+         * Reads a whole file into dst, reusing its memory.
+         * @return false if the file could not be read.
+         */
+        bool readfile(const std::string &path, std::vector<byte> &dst);
+
+        /**
+         * Reads a source until its end into dst, in blocks.
+         */
+        void readsource(io::inputsource &source, std::vector<byte> &dst);
+
+        /**
+         * Runs a document step, letting it through when the only problem is errors in the markup. The document
+         * methods throw on Tidy's status 2, but the tree is still there and is saved if force-output is set.
+         * Timeouts, limit violations and other failures are rethrown.
+         */
+        template <class F>
+        void tolerant(document &doc, F step)
+        {
+            try
+            {
+                step();
+            }
+            catch (const timeout &)
+            {
+                throw;
+            }
+            catch (const limitexceeded &)
+            {
+                throw;
+            }
+            catch (const exception &)
+            {
+                if (doc.status() != 2)
+                    throw;
+            }
+        }
+    }
+}
@@ -0,0 +1,418 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#include "../include/tidypp/links.hpp"
+#include "../include/tidypp/document.hpp"
+#include "../include/tidypp/node.hpp"
+#include "../include/tidypp/attribute.hpp"
+#include <ctype.h>
+#include <string.h>
+#include <strings.h>
+
+namespace tidypp
+{
+    namespace
+    {
+        constexpr tagset hreftags(TidyTag_A, TidyTag_AREA, TidyTag_LINK);
+        constexpr tagset srctags(TidyTag_IMG, TidyTag_SCRIPT, TidyTag_IFRAME, TidyTag_FRAME, TidyTag_EMBED,
+            TidyTag_INPUT);
+        constexpr tagset linktags = hreftags | srctags | tagset(TidyTag_FORM);
+
+        bool isspacechar(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+        }
+
+        // strips leading and trailing whitespace
+        void trim(const char *&s, size_t &len)
+        {
+            while (len && isspacechar(*s))
+            {
+                s++;
+                len--;
+            }
+
+            while (len && isspacechar(s[len - 1]))
+                len--;
+        }
+
+        // length of the scheme including the colon, 0 if the reference is relative
+        size_t schemelength(const char *s, size_t len)
+        {
+            if (!len || !isalpha(static_cast<unsigned char>(s[0])))
+                return 0;
+
+            for (size_t i = 1; i < len; i++)
+            {
+                char c = s[i];
+
+                if (c == ':')
+                    return i + 1;
+
+                if (!isalnum(static_cast<unsigned char>(c)) && c != '+' && c != '-' && c != '.')
+                    return 0;
+            }
+
+            return 0;
+        }
+
+        // drops the last segment (and its slash) from the output path, which starts at floor
+        void popsegment(std::string &out, size_t floor)
+        {
+            size_t slash = out.rfind('/');
+            out.erase(slash == std::string::npos || slash < floor ? floor : slash);
+        }
+
+        // appends path to out, applying RFC 3986 5.2.4 remove_dot_segments
+        void removedots(std::string path, std::string &out)
+        {
+            size_t floor = out.size();
+            size_t p = 0;
+            size_t n = path.size();
+
+            while (p < n)
+            {
+                size_t rest = n - p;
+                const char *in = path.c_str() + p;
+
+                if (!strncmp(in, "../", 3))
+                    p += 3;
+                else if (!strncmp(in, "./", 2))
+                    p += 2;
+                else if (!strncmp(in, "/./", 3))
+                    p += 2;
+                else if (rest == 2 && !strncmp(in, "/.", 2))
+                    path[++p] = '/';
+                else if (!strncmp(in, "/../", 4))
+                {
+                    p += 3;
+                    popsegment(out, floor);
+                }
+                else if (rest == 3 && !strncmp(in, "/..", 3))
+                {
+                    p += 2;
+                    path[p] = '/';
+                    popsegment(out, floor);
+                }
+                else if ((rest == 1 && in[0] == '.') || (rest == 2 && !strncmp(in, "..", 2)))
+                    p = n;
+                else
+                {
+                    size_t q = path.find('/', p + 1);
+
+                    if (q == std::string::npos)
+                        q = n;
+
+                    out.append(path, p, q - p);
+                    p = q;
+                }
+            }
+        }
+    }
+
+    void resolveurl(const std::string &base, const char *ref, size_t len, std::string &dst)
+    {
+        size_t scheme = schemelength(ref, len);
+
+        dst.clear();
+
+        if (scheme || base.empty())
+        {
+            dst.assign(ref, len);
+            return;
+        }
+
+        // split the base into scheme, authority and path, dropping its query and fragment
+        size_t bscheme = schemelength(base.data(), base.size());
+        size_t bpath = bscheme;
+        size_t bend = base.find('#');
+
+        if (bend == std::string::npos)
+            bend = base.size();
+
+        if (!base.compare(bscheme, 2, "//"))
+        {
+            bpath = base.find_first_of("/?#", bscheme + 2);
+
+            if (bpath == std::string::npos || bpath > bend)
+                bpath = bend;
+        }
+
+        size_t bquery = base.find('?', bpath);
+
+        if (bquery == std::string::npos || bquery > bend)
+            bquery = bend;
+
+        if (len >= 2 && ref[0] == '/' && ref[1] == '/')
+        {
+            // network-path reference
+            dst.assign(base, 0, bscheme);
+            dst.append(ref, len);
+            return;
+        }
+
+        if (!len || ref[0] == '#')
+        {
+            dst.assign(base, 0, bend);
+            dst.append(ref, len);
+            return;
+        }
+
+        if (ref[0] == '?')
+        {
+            dst.assign(base, 0, bquery);
+            dst.append(ref, len);
+            return;
+        }
+
+        size_t rpath = 0;
+
+        while (rpath < len && ref[rpath] != '?' && ref[rpath] != '#')
+            rpath++;
+
+        std::string path;
+
+        if (ref[0] == '/')
+            path.assign(ref, rpath);
+        else
+        {
+            // merge with the directory of the base path
+            size_t slash = base.rfind('/', bquery ? bquery - 1 : 0);
+
+            if (bpath == bquery && bpath > bscheme)
+                path = "/";
+            else if (slash != std::string::npos && slash >= bpath)
+                path.assign(base, bpath, slash + 1 - bpath);
+
+            path.append(ref, rpath);
+        }
+
+        dst.assign(base, 0, bpath);
+        removedots(path, dst);
+        dst.append(ref + rpath, len - rpath);
+    }
+
+    // linkset methods
+    const linkset::index linkset::npos;
+
+    linkset::linkset() throw()
+    {
+        // empty
+    }
+
+    linkset::~linkset() throw()
+    {
+        // empty
+    }
+
+    void linkset::clear() throw()
+    {
+        arena.clear();
+        offsets.clear();
+        lengths.clear();
+        table.assign(table.size(), npos);
+        occurrences.clear();
+        basehref.clear();
+    }
+
+    linkset::index linkset::intern(const char *s, size_t len)
+    {
+        if ((offsets.size() + 1) * 2 > table.size())
+            grow();
+
+        size_t mask = table.size() - 1;
+
+        for (size_t slot = static_cast<size_t>(fasthash(s, len)) & mask; ; slot = (slot + 1) & mask)
+        {
+            index i = table[slot];
+
+            if (i == npos)
+            {
+                i = static_cast<index>(offsets.size());
+                offsets.push_back(static_cast<uint32_t>(arena.size()));
+                lengths.push_back(static_cast<uint32_t>(len));
+                arena.append(s, len);
+                arena.push_back('\0');
+                table[slot] = i;
+
+                return i;
+            }
+
+            if (lengths[i] == len && !memcmp(arena.data() + offsets[i], s, len))
+                return i;
+        }
+    }
+
+    void linkset::add(tagid tag, attributeid attr, const char *s, size_t len)
+    {
+        trim(s, len);
+
+        if (!len)
+            return;
+
+        link l;
+
+        l.tag = tag;
+        l.attr = attr;
+
+        if (basehref.empty() || schemelength(s, len))
+            l.url = intern(s, len);
+        else
+        {
+            resolveurl(basehref, s, len, scratch);
+            l.url = intern(scratch.data(), scratch.size());
+        }
+
+        occurrences.push_back(l);
+    }
+
+    linkset::index linkset::urlcount() const throw()
+    {
+        return static_cast<index>(offsets.size());
+    }
+
+    const char *linkset::url(index i) const throw()
+    {
+        return arena.c_str() + offsets[i];
+    }
+
+    size_t linkset::urllength(index i) const throw()
+    {
+        return lengths[i];
+    }
+
+    const std::vector<linkset::link> &linkset::links() const throw()
+    {
+        return occurrences;
+    }
+
+    const std::string &linkset::base() const throw()
+    {
+        return basehref;
+    }
+
+    void linkset::setbase(const std::string &href)
+    {
+        const char *s = href.data();
+        size_t len = href.size();
+
+        trim(s, len);
+        basehref.assign(s, len);
+    }
+
+    void linkset::grow()
+    {
+        table.assign(table.empty() ? 64 : table.size() * 2, npos);
+
+        size_t mask = table.size() - 1;
+
+        for (index i = 0; i < offsets.size(); i++)
+        {
+            size_t slot = static_cast<size_t>(fasthash(arena.data() + offsets[i], lengths[i])) & mask;
+
+            while (table[slot] != npos)
+                slot = (slot + 1) & mask;
+
+            table[slot] = i;
+        }
+    }
+
+    void extract_links(document &doc, linkset &dst)
+    {
+        node head = doc.head();
+
+        dst.clear();
+
+        // only the first base element with an href counts, and it must be in the head
+        if (head.valid())
+        {
+            for (node &n : head.children())
+            {
+                if (n.id() != TidyTag_BASE)
+                    continue;
+
+                attribute href = n.attrgetbyid(TidyAttr_HREF);
+
+                if (href.valid() && href.value())
+                {
+                    dst.setbase(href.value());
+                    break;
+                }
+            }
+        }
+
+        for (node &n : doc.root().descendants())
+        {
+            if (!n.in(linktags))
+                continue;
+
+            tagid tag = n.id();
+            attributeid id = hreftags.contains(tag) ? TidyAttr_HREF : srctags.contains(tag) ? TidyAttr_SRC :
+                TidyAttr_ACTION;
+            attribute attr = n.attrgetbyid(id);
+            ctmbstr value = attr.valid() ? attr.value() : NULL;
+
+            if (value)
+                dst.add(tag, id, value, strlen(value));
+
+            if (tag != TidyTag_IMG)
+                continue;
+
+            // srcset is newer than Tidy's attribute table, look it up by name
+            for (attr = n.attrfirst(); attr.valid(); attr = attr.next())
+            {
+                ctmbstr name = attr.name();
+
+                if (!name || strcasecmp(name, "srcset") || !(value = attr.value()))
+                    continue;
+
+                // comma separated candidates, each made of a url and an optional descriptor
+                for (ctmbstr p = value; *p; )
+                {
+                    while (isspacechar(*p) || *p == ',')
+                        p++;
+
+                    ctmbstr start = p;
+
+                    while (*p && !isspacechar(*p))
+                        p++;
+
+                    size_t len = p - start;
+
+                    // a comma right after the url ends the candidate
+                    bool ended = len && start[len - 1] == ',';
+
+                    while (len && start[len - 1] == ',')
+                        len--;
+
+                    dst.add(tag, TidyAttr_UNKNOWN, start, len);
+
+                    if (!ended)
+                    {
+                        while (*p && *p != ',')
+                            p++;
+                    }
+                }
+
+                break;
+            }
+        }
+    }
+}
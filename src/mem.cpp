@@ -19,6 +19,9 @@
 */
 
 #include "../include/tidypp/mem.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 namespace tidypp
 {
@@ -44,5 +47,312 @@ namespace tidypp
         {
             return tidySetReallocCall(frealloc);
         }
+
+        namespace
+        {
+            // every block starts with a header that remembers its size, padded to keep the payload aligned
+            union header
+            {
+                size_t size;
+                long double align;
+            };
+
+            const size_t smallest = 16;
+            const size_t largest = 2048;
+
+            // size class of a small block, classcount for big ones
+            size_t classof(size_t size)
+            {
+                size_t c = 0;
+
+                for (size_t s = smallest; s < size; s <<= 1)
+                    c++;
+
+                return c;
+            }
+
+            header *headerof(void *block)
+            {
+                return static_cast<header *>(block) - 1;
+            }
+        }
+
+        // pool methods
+        const allocatorvtbl pool::poolvtbl =
+        {
+            pool::poolalloc,
+            pool::poolrealloc,
+            pool::poolfree,
+            pool::poolpanic
+        };
+
+        pool::pool() throw()
+            : used(0), peakused(0), cachedbytes(0)
+        {
+            vtbl = &poolvtbl;
+            memset(freelists, 0, sizeof(freelists));
+        }
+
+        pool::~pool() throw()
+        {
+            trim();
+        }
+
+        void pool::trim() throw()
+        {
+            for (size_t i = 0; i < classcount; i++)
+            {
+                while (freelists[i])
+                {
+                    freeblock *b = freelists[i];
+
+                    freelists[i] = b->next;
+                    ::free(headerof(b));
+                }
+            }
+
+            cachedbytes = 0;
+        }
+
+        size_t pool::inuse() const throw()
+        {
+            return used;
+        }
+
+        size_t pool::peak() const throw()
+        {
+            return peakused;
+        }
+
+        void pool::resetpeak() throw()
+        {
+            peakused = used;
+        }
+
+        size_t pool::cached() const throw()
+        {
+            return cachedbytes;
+        }
+
+        void *TIDY_CALL pool::poolalloc(allocator *self, size_t size)
+        {
+            pool *p = static_cast<pool *>(self);
+            size_t c = size <= largest ? classof(size) : classcount;
+            size_t real = c < classcount ? smallest << c : size;
+            void *block;
+
+            if (c < classcount && p->freelists[c])
+            {
+                freeblock *b = p->freelists[c];
+
+                p->freelists[c] = b->next;
+                p->cachedbytes -= real;
+                block = b;
+            }
+            else
+            {
+                header *h = static_cast<header *>(::malloc(sizeof(header) + real));
+
+                if (!h)
+                {
+                    poolpanic(self, "Out of memory!");
+                    return NULL;
+                }
+
+                h->size = real;
+                block = h + 1;
+            }
+
+            p->used += real;
+
+            if (p->used > p->peakused)
+                p->peakused = p->used;
+
+            return block;
+        }
+
+        void *TIDY_CALL pool::poolrealloc(allocator *self, void *block, size_t size)
+        {
+            if (!block)
+                return poolalloc(self, size);
+
+            size_t old = headerof(block)->size;
+
+            // the block is already big enough, and not so big that shrinking would be worth a copy
+            if (size <= old && (old <= largest || size > old / 2))
+                return block;
+
+            pool *p = static_cast<pool *>(self);
+
+            if (old > largest && size > largest)
+            {
+                header *h = static_cast<header *>(::realloc(headerof(block), sizeof(header) + size));
+
+                if (!h)
+                {
+                    poolpanic(self, "Out of memory!");
+                    return NULL;
+                }
+
+                p->used = p->used - old + size;
+                h->size = size;
+
+                if (p->used > p->peakused)
+                    p->peakused = p->used;
+
+                return h + 1;
+            }
+
+            void *res = poolalloc(self, size);
+
+            if (res)
+            {
+                memcpy(res, block, old < size ? old : size);
+                poolfree(self, block);
+            }
+
+            return res;
+        }
+
+        void TIDY_CALL pool::poolfree(allocator *self, void *block)
+        {
+            if (!block)
+                return;
+
+            pool *p = static_cast<pool *>(self);
+            size_t size = headerof(block)->size;
+
+            p->used -= size;
+
+            if (size > largest)
+            {
+                ::free(headerof(block));
+                return;
+            }
+
+            size_t c = classof(size);
+            freeblock *b = static_cast<freeblock *>(block);
+
+            b->next = p->freelists[c];
+            p->freelists[c] = b;
+            p->cachedbytes += size;
+        }
+
+        void TIDY_CALL pool::poolpanic(allocator *, ctmbstr msg)
+        {
+            // same as Tidy's default panic handler
+            fprintf(stderr, "Fatal error: %s\n", msg);
+            exit(2);
+        }
+
+        namespace
+        {
+            thread_local allocator *current = NULL; // selected by the thread, NULL for the C library
+
+            // routed blocks remember their allocator, NULL for the C library
+            union routeheader
+            {
+                allocator *owner;
+                long double align;
+            };
+
+            routeheader *routeheaderof(void *block)
+            {
+                return static_cast<routeheader *>(block) - 1;
+            }
+
+            void TIDY_CALL routepanic(ctmbstr msg)
+            {
+                if (current)
+                    current->vtbl->panic(current, msg);
+
+                // same as Tidy's default panic handler
+                fprintf(stderr, "Fatal error: %s\n", msg);
+                exit(2);
+            }
+
+            void *TIDY_CALL routemalloc(size_t size)
+            {
+                allocator *a = current;
+                routeheader *h;
+
+                if (a)
+                    h = static_cast<routeheader *>(a->vtbl->alloc(a, sizeof(routeheader) + size));
+                else
+                    h = static_cast<routeheader *>(::malloc(sizeof(routeheader) + size));
+
+                if (!h)
+                    return NULL;
+
+                h->owner = a;
+                return h + 1;
+            }
+
+            void *TIDY_CALL routerealloc(void *block, size_t size)
+            {
+                if (!block)
+                    return routemalloc(size);
+
+                routeheader *h = routeheaderof(block);
+                allocator *a = h->owner;
+
+                if (a)
+                    h = static_cast<routeheader *>(a->vtbl->realloc(a, h, sizeof(routeheader) + size));
+                else
+                    h = static_cast<routeheader *>(::realloc(h, sizeof(routeheader) + size));
+
+                if (!h)
+                    return NULL;
+
+                return h + 1;
+            }
+
+            void TIDY_CALL routefree(void *block)
+            {
+                if (!block)
+                    return;
+
+                routeheader *h = routeheaderof(block);
+
+                if (h->owner)
+                    h->owner->vtbl->free(h->owner, h);
+                else
+                    ::free(h);
+            }
+        }
+
+        // routing functions
+        bool routethreads()
+        {
+            static bool installed = tidySetMallocCall(routemalloc) && tidySetReallocCall(routerealloc) &&
+                                    tidySetFreeCall(routefree) && tidySetPanicCall(routepanic);
+
+            return installed;
+        }
+
+        allocator *setthreadallocator(allocator *a) throw()
+        {
+            allocator *previous = current;
+
+            current = a;
+            return previous;
+        }
+
+        allocator *getthreadallocator() throw()
+        {
+            return current;
+        }
+
+        // threadscope methods
+        threadscope::threadscope(allocator &a) throw()
+            : previous(setthreadallocator(&a))
+        {
+            // empty
+        }
+
+        threadscope::~threadscope() throw()
+        {
+            setthreadallocator(previous);
+        }
     }
 }
@@ -0,0 +1,413 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+#include "../include/tidypp/metrics.hpp"
+#include "../include/tidypp/document.hpp"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <thread>
+
+namespace tidypp
+{
+    namespace
+    {
+        const char *phasenames[metrics::phasecount] = { "parse", "clean", "diagnostics", "save" };
+
+        // index of the highest set bit, v must not be 0
+        uint highbit(uint64_t v)
+        {
+            uint res = 0;
+
+            for (uint shift = 32; shift; shift /= 2)
+            {
+                if (v >> shift)
+                {
+                    v >>= shift;
+                    res += shift;
+                }
+            }
+
+            return res;
+        }
+
+        uint64_t microseconds(double seconds)
+        {
+            return seconds > 0 ? static_cast<uint64_t>(std::llround(seconds * 1e6)) : 0;
+        }
+
+        void appendf(std::string &dst, const char *format, ...)
+        {
+            char buf[512];
+            va_list args;
+
+            va_start(args, format);
+            int len = vsnprintf(buf, sizeof(buf), format, args);
+            va_end(args);
+
+            if (len > 0)
+                dst.append(buf, static_cast<size_t>(len) < sizeof(buf) ? len : sizeof(buf) - 1);
+        }
+
+        void header(std::string &dst, const std::string &name, const char *type, const char *help)
+        {
+            appendf(dst, "# HELP %s %s\n# TYPE %s %s\n", name.c_str(), help, name.c_str(), type);
+        }
+
+        void counter(std::string &dst, const std::string &prefix, const char *name, const char *help,
+                     uint64_t value)
+        {
+            std::string full = prefix + "_" + name;
+
+            header(dst, full, "counter", help);
+            appendf(dst, "%s %llu\n", full.c_str(), static_cast<unsigned long long>(value));
+        }
+
+        // one series of a histogram, buckets at each power of two between 2^first and 2^last times scale
+        void series(std::string &dst, const std::string &name, const char *labels, const metrics::histogram &h,
+                    uint first, uint last, double scale)
+        {
+            const char *sep = *labels ? "," : "";
+
+            for (uint k = first; k <= last; k++)
+            {
+                appendf(dst, "%s_bucket{%s%sle=\"%.10g\"} %llu\n", name.c_str(), labels, sep,
+                        static_cast<double>(1ULL << k) * scale,
+                        static_cast<unsigned long long>(h.countupto(1ULL << k)));
+            }
+
+            appendf(dst, "%s_bucket{%s%sle=\"+Inf\"} %llu\n", name.c_str(), labels, sep,
+                    static_cast<unsigned long long>(h.count()));
+
+            if (*labels)
+            {
+                appendf(dst, "%s_sum{%s} %.10g\n%s_count{%s} %llu\n", name.c_str(), labels, h.sum() * scale,
+                        name.c_str(), labels, static_cast<unsigned long long>(h.count()));
+            }
+            else
+            {
+                appendf(dst, "%s_sum %.10g\n%s_count %llu\n", name.c_str(), h.sum() * scale, name.c_str(),
+                        static_cast<unsigned long long>(h.count()));
+            }
+        }
+    }
+
+    // metrics::histogram methods
+    metrics::histogram::histogram() throw()
+    {
+        clear();
+    }
+
+    void metrics::histogram::record(uint64_t value) throw()
+    {
+        // buckets hold value - 1 so that each one includes its upper edge; 0 shares the first one with 1
+        uint64_t key = value ? value - 1 : 0;
+
+        if (!(key >> maxbits))
+            buckets[bucketof(key)]++;
+
+        n++;
+        total += value;
+
+        if (value > highest)
+            highest = value;
+    }
+
+    void metrics::histogram::merge(const histogram &other) throw()
+    {
+        for (uint b = 0; b < bucketcount; b++)
+            buckets[b] += other.buckets[b];
+
+        n += other.n;
+        total += other.total;
+
+        if (other.highest > highest)
+            highest = other.highest;
+    }
+
+    void metrics::histogram::clear() throw()
+    {
+        memset(buckets, 0, sizeof(buckets));
+        n = total = highest = 0;
+    }
+
+    uint64_t metrics::histogram::count() const throw()
+    {
+        return n;
+    }
+
+    uint64_t metrics::histogram::sum() const throw()
+    {
+        return total;
+    }
+
+    uint64_t metrics::histogram::max() const throw()
+    {
+        return highest;
+    }
+
+    uint64_t metrics::histogram::quantile(double q) const throw()
+    {
+        if (!n)
+            return 0;
+
+        uint64_t rank = static_cast<uint64_t>(std::ceil(q * n));
+        uint64_t seen = 0;
+
+        if (rank < 1)
+            rank = 1;
+
+        for (uint b = 0; b < bucketcount; b++)
+        {
+            seen += buckets[b];
+
+            if (seen >= rank)
+            {
+                uint64_t upper = lowerbound(b + 1);
+                return upper < highest ? upper : highest;
+            }
+        }
+
+        return highest;
+    }
+
+    uint64_t metrics::histogram::countupto(uint64_t bound) const throw()
+    {
+        // values up to bound are the keys below bound, see record()
+        uint end = bound >> maxbits ? bucketcount : bucketof(bound);
+        uint64_t res = 0;
+
+        for (uint b = 0; b < end; b++)
+            res += buckets[b];
+
+        return res;
+    }
+
+    uint metrics::histogram::bucketof(uint64_t value) throw()
+    {
+        if (value < subcount)
+            return static_cast<uint>(value);
+
+        uint msb = highbit(value);
+
+        // subcount linear buckets between 2^msb and 2^(msb + 1)
+        uint shift = msb - subbits;
+        return subcount + shift * subcount + static_cast<uint>((value >> shift) - subcount);
+    }
+
+    uint64_t metrics::histogram::lowerbound(uint b) throw()
+    {
+        if (b < subcount)
+            return b;
+
+        uint shift = (b - subcount) / subcount;
+        return static_cast<uint64_t>(subcount + (b - subcount) % subcount) << shift;
+    }
+
+    // metrics::totals methods
+    metrics::totals::totals() throw()
+        : documents(0), failures(0), bytesin(0), bytesout(0), nodes(0), errors(0), warnings(0)
+    {
+        for (int p = 0; p < phasecount; p++)
+            cpu[p] = 0;
+    }
+
+    void metrics::totals::merge(const totals &other) throw()
+    {
+        for (int p = 0; p < phasecount; p++)
+        {
+            phases[p].merge(other.phases[p]);
+            cpu[p] += other.cpu[p];
+        }
+
+        peaks.merge(other.peaks);
+        documents += other.documents;
+        failures += other.failures;
+        bytesin += other.bytesin;
+        bytesout += other.bytesout;
+        nodes += other.nodes;
+        errors += other.errors;
+        warnings += other.warnings;
+    }
+
+    // metrics methods
+    metrics::metrics(size_t shards)
+    {
+        size_t n = 1;
+
+        if (!shards)
+            shards = std::thread::hardware_concurrency();
+
+        while (n < shards)
+            n *= 2;
+
+        this->shards.resize(n);
+
+        for (size_t i = 0; i < n; i++)
+            this->shards[i] = new shard;
+    }
+
+    metrics::~metrics() throw()
+    {
+        for (size_t i = 0; i < shards.size(); i++)
+            delete shards[i];
+    }
+
+    void metrics::record(document &doc, bool ok)
+    {
+        const document::statistics &st = doc.stats();
+        const document::statistics::timing *timings[phasecount] = { &st.parse, &st.clean, &st.diagnostics,
+                                                                    &st.save };
+        uint errors = doc.errorcount();
+        uint warnings = doc.warningcount();
+        shard &s = getshard();
+        std::lock_guard<std::mutex> guard(s.lock);
+
+        for (int p = 0; p < phasecount; p++)
+        {
+            if (timings[p]->calls)
+            {
+                s.data.phases[p].record(microseconds(timings[p]->wall));
+                s.data.cpu[p] += timings[p]->cpu;
+            }
+        }
+
+        s.data.documents++;
+        s.data.failures += !ok;
+        s.data.bytesin += st.bytesin;
+        s.data.bytesout += st.bytesout;
+        s.data.nodes += st.nodes;
+        s.data.errors += errors;
+        s.data.warnings += warnings;
+    }
+
+    void metrics::recordphase(phase p, double wall, double cpu)
+    {
+        shard &s = getshard();
+        std::lock_guard<std::mutex> guard(s.lock);
+
+        s.data.phases[p].record(microseconds(wall));
+        s.data.cpu[p] += cpu;
+    }
+
+    void metrics::recordpeak(size_t bytes)
+    {
+        shard &s = getshard();
+        std::lock_guard<std::mutex> guard(s.lock);
+
+        s.data.peaks.record(bytes);
+    }
+
+    void metrics::collect(totals &dst)
+    {
+        dst = totals();
+
+        for (size_t i = 0; i < shards.size(); i++)
+        {
+            std::lock_guard<std::mutex> guard(shards[i]->lock);
+            dst.merge(shards[i]->data);
+        }
+    }
+
+    void metrics::reset()
+    {
+        for (size_t i = 0; i < shards.size(); i++)
+        {
+            std::lock_guard<std::mutex> guard(shards[i]->lock);
+            shards[i]->data = totals();
+        }
+    }
+
+    void metrics::prometheus(std::string &dst, const std::string &prefix)
+    {
+        std::unique_ptr<totals> t(new totals); // a few tens of KB, keep it off the stack
+        std::string name;
+
+        collect(*t);
+
+        counter(dst, prefix, "documents_total", "Documents processed.", t->documents);
+        counter(dst, prefix, "failures_total", "Documents that failed.", t->failures);
+        counter(dst, prefix, "input_bytes_total", "Bytes of markup parsed.", t->bytesin);
+        counter(dst, prefix, "output_bytes_total", "Bytes of markup saved.", t->bytesout);
+        counter(dst, prefix, "nodes_total", "Nodes in the parsed documents.", t->nodes);
+        counter(dst, prefix, "errors_total", "Errors reported by Tidy.", t->errors);
+        counter(dst, prefix, "warnings_total", "Warnings reported by Tidy.", t->warnings);
+
+        // latencies from 1 microsecond to about 70 minutes
+        name = prefix + "_phase_seconds";
+        header(dst, name, "histogram", "Wall-clock time of each phase, per document.");
+
+        for (int p = 0; p < phasecount; p++)
+            series(dst, name, (std::string("phase=\"") + phasenames[p] + "\"").c_str(), t->phases[p], 0, 32, 1e-6);
+
+        name = prefix + "_phase_cpu_seconds_total";
+        header(dst, name, "counter", "CPU time of each phase.");
+
+        for (int p = 0; p < phasecount; p++)
+            appendf(dst, "%s{phase=\"%s\"} %.10g\n", name.c_str(), phasenames[p], t->cpu[p]);
+
+        // peaks from 1 KB to 64 GB
+        name = prefix + "_allocation_peak_bytes";
+        header(dst, name, "histogram", "Peak memory allocated while processing a document.");
+        series(dst, name, "", t->peaks, 10, 36, 1);
+    }
+
+    std::string metrics::prometheus(const std::string &prefix)
+    {
+        std::string res;
+
+        prometheus(res, prefix);
+
+        return res;
+    }
+
+    void metrics::writeprometheus(const std::string &path, const std::string &prefix) throw(const exception &)
+    {
+        std::string text = prometheus(prefix);
+        std::string tmp = path + ".tmp";
+        FILE *f = fopen(tmp.c_str(), "wb");
+
+        if (!f)
+            throw exception("metrics.writeprometheus: failed to open " + tmp + ".");
+
+        bool ok = fwrite(text.data(), 1, text.size(), f) == text.size();
+
+#ifdef _WIN32
+        remove(path.c_str()); // rename() doesn't replace existing files here
+#endif
+
+        if (fclose(f) || !ok || rename(tmp.c_str(), path.c_str()))
+        {
+            remove(tmp.c_str());
+            throw exception("metrics.writeprometheus: failed to write " + path + ".");
+        }
+    }
+
+    metrics::shard &metrics::getshard() throw()
+    {
+        // each thread takes the next shard the first time it records anything
+        static std::atomic<size_t> next(0);
+        static thread_local size_t mine = next++;
+
+        return *shards[mine & (shards.size() - 1)];
+    }
+}
@@ -0,0 +1,231 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#include "../include/tidypp/names.hpp"
+#include <ctype.h>
+#include <string.h>
+#include <strings.h>
+#include <vector>
+
+namespace tidypp
+{
+    namespace
+    {
+        struct tagname
+        {
+            const char *name;
+            tagid id;
+        };
+
+        struct attrname
+        {
+            const char *name;
+            attributeid id;
+        };
+
+        // tags and attributes known to every Tidy release
+        const tagname tagnames[] =
+        {
+            { "a", TidyTag_A }, { "abbr", TidyTag_ABBR }, { "acronym", TidyTag_ACRONYM },
+            { "address", TidyTag_ADDRESS }, { "applet", TidyTag_APPLET }, { "area", TidyTag_AREA },
+            { "b", TidyTag_B }, { "base", TidyTag_BASE }, { "basefont", TidyTag_BASEFONT }, { "bdo", TidyTag_BDO },
+            { "bgsound", TidyTag_BGSOUND }, { "big", TidyTag_BIG }, { "blink", TidyTag_BLINK },
+            { "blockquote", TidyTag_BLOCKQUOTE }, { "body", TidyTag_BODY }, { "br", TidyTag_BR },
+            { "button", TidyTag_BUTTON }, { "caption", TidyTag_CAPTION }, { "center", TidyTag_CENTER },
+            { "cite", TidyTag_CITE }, { "code", TidyTag_CODE }, { "col", TidyTag_COL },
+            { "colgroup", TidyTag_COLGROUP }, { "dd", TidyTag_DD }, { "del", TidyTag_DEL }, { "dfn", TidyTag_DFN },
+            { "dir", TidyTag_DIR }, { "div", TidyTag_DIV }, { "dl", TidyTag_DL }, { "dt", TidyTag_DT },
+            { "em", TidyTag_EM }, { "embed", TidyTag_EMBED }, { "fieldset", TidyTag_FIELDSET },
+            { "font", TidyTag_FONT }, { "form", TidyTag_FORM }, { "frame", TidyTag_FRAME },
+            { "frameset", TidyTag_FRAMESET }, { "h1", TidyTag_H1 }, { "h2", TidyTag_H2 }, { "h3", TidyTag_H3 },
+            { "h4", TidyTag_H4 }, { "h5", TidyTag_H5 }, { "h6", TidyTag_H6 }, { "head", TidyTag_HEAD },
+            { "hr", TidyTag_HR }, { "html", TidyTag_HTML }, { "i", TidyTag_I }, { "iframe", TidyTag_IFRAME },
+            { "ilayer", TidyTag_ILAYER }, { "img", TidyTag_IMG }, { "input", TidyTag_INPUT }, { "ins", TidyTag_INS },
+            { "isindex", TidyTag_ISINDEX }, { "kbd", TidyTag_KBD }, { "keygen", TidyTag_KEYGEN },
+            { "label", TidyTag_LABEL }, { "layer", TidyTag_LAYER }, { "legend", TidyTag_LEGEND },
+            { "li", TidyTag_LI }, { "link", TidyTag_LINK }, { "listing", TidyTag_LISTING }, { "map", TidyTag_MAP },
+            { "marquee", TidyTag_MARQUEE }, { "menu", TidyTag_MENU }, { "meta", TidyTag_META },
+            { "multicol", TidyTag_MULTICOL }, { "nobr", TidyTag_NOBR }, { "noembed", TidyTag_NOEMBED },
+            { "noframes", TidyTag_NOFRAMES }, { "nolayer", TidyTag_NOLAYER }, { "nosave", TidyTag_NOSAVE },
+            { "noscript", TidyTag_NOSCRIPT }, { "object", TidyTag_OBJECT }, { "ol", TidyTag_OL },
+            { "optgroup", TidyTag_OPTGROUP }, { "option", TidyTag_OPTION }, { "p", TidyTag_P },
+            { "param", TidyTag_PARAM }, { "plaintext", TidyTag_PLAINTEXT }, { "pre", TidyTag_PRE },
+            { "q", TidyTag_Q }, { "rb", TidyTag_RB }, { "rbc", TidyTag_RBC }, { "rp", TidyTag_RP },
+            { "rt", TidyTag_RT }, { "rtc", TidyTag_RTC }, { "ruby", TidyTag_RUBY }, { "s", TidyTag_S },
+            { "samp", TidyTag_SAMP }, { "script", TidyTag_SCRIPT }, { "select", TidyTag_SELECT },
+            { "server", TidyTag_SERVER }, { "servlet", TidyTag_SERVLET }, { "small", TidyTag_SMALL },
+            { "spacer", TidyTag_SPACER }, { "span", TidyTag_SPAN }, { "strike", TidyTag_STRIKE },
+            { "strong", TidyTag_STRONG }, { "style", TidyTag_STYLE }, { "sub", TidyTag_SUB },
+            { "sup", TidyTag_SUP }, { "table", TidyTag_TABLE }, { "tbody", TidyTag_TBODY }, { "td", TidyTag_TD },
+            { "textarea", TidyTag_TEXTAREA }, { "tfoot", TidyTag_TFOOT }, { "th", TidyTag_TH },
+            { "thead", TidyTag_THEAD }, { "title", TidyTag_TITLE }, { "tr", TidyTag_TR }, { "tt", TidyTag_TT },
+            { "u", TidyTag_U }, { "ul", TidyTag_UL }, { "var", TidyTag_VAR }, { "wbr", TidyTag_WBR },
+            { "xmp", TidyTag_XMP }
+        };
+
+        const attrname attrnames[] =
+        {
+            { "abbr", TidyAttr_ABBR }, { "accept", TidyAttr_ACCEPT }, { "accept-charset", TidyAttr_ACCEPT_CHARSET },
+            { "accesskey", TidyAttr_ACCESSKEY }, { "action", TidyAttr_ACTION }, { "align", TidyAttr_ALIGN },
+            { "alt", TidyAttr_ALT }, { "archive", TidyAttr_ARCHIVE }, { "background", TidyAttr_BACKGROUND },
+            { "bgcolor", TidyAttr_BGCOLOR }, { "border", TidyAttr_BORDER }, { "cellpadding", TidyAttr_CELLPADDING },
+            { "cellspacing", TidyAttr_CELLSPACING }, { "charset", TidyAttr_CHARSET },
+            { "checked", TidyAttr_CHECKED }, { "cite", TidyAttr_CITE }, { "class", TidyAttr_CLASS },
+            { "classid", TidyAttr_CLASSID }, { "code", TidyAttr_CODE }, { "codebase", TidyAttr_CODEBASE },
+            { "cols", TidyAttr_COLS }, { "colspan", TidyAttr_COLSPAN }, { "content", TidyAttr_CONTENT },
+            { "coords", TidyAttr_COORDS }, { "data", TidyAttr_DATA }, { "datetime", TidyAttr_DATETIME },
+            { "dir", TidyAttr_DIR }, { "disabled", TidyAttr_DISABLED }, { "enctype", TidyAttr_ENCTYPE },
+            { "for", TidyAttr_FOR }, { "headers", TidyAttr_HEADERS }, { "height", TidyAttr_HEIGHT },
+            { "href", TidyAttr_HREF }, { "hreflang", TidyAttr_HREFLANG }, { "http-equiv", TidyAttr_HTTP_EQUIV },
+            { "id", TidyAttr_ID }, { "label", TidyAttr_LABEL }, { "lang", TidyAttr_LANG },
+            { "longdesc", TidyAttr_LONGDESC }, { "maxlength", TidyAttr_MAXLENGTH }, { "media", TidyAttr_MEDIA },
+            { "method", TidyAttr_METHOD }, { "multiple", TidyAttr_MULTIPLE }, { "name", TidyAttr_NAME },
+            { "nohref", TidyAttr_NOHREF }, { "profile", TidyAttr_PROFILE }, { "readonly", TidyAttr_READONLY },
+            { "rel", TidyAttr_REL }, { "rev", TidyAttr_REV }, { "rows", TidyAttr_ROWS },
+            { "rowspan", TidyAttr_ROWSPAN }, { "scope", TidyAttr_SCOPE }, { "selected", TidyAttr_SELECTED },
+            { "shape", TidyAttr_SHAPE }, { "size", TidyAttr_SIZE }, { "span", TidyAttr_SPAN },
+            { "src", TidyAttr_SRC }, { "start", TidyAttr_START }, { "style", TidyAttr_STYLE },
+            { "summary", TidyAttr_SUMMARY }, { "tabindex", TidyAttr_TABINDEX }, { "target", TidyAttr_TARGET },
+            { "title", TidyAttr_TITLE }, { "type", TidyAttr_TYPE }, { "usemap", TidyAttr_USEMAP },
+            { "valign", TidyAttr_VALIGN }, { "value", TidyAttr_VALUE }, { "width", TidyAttr_WIDTH },
+            { "xmlns", TidyAttr_XMLNS }
+        };
+
+        const size_t maxname = 32; /**< Longer names are never in the tables. */
+
+        // lowercases name into buf, returns false if it is too long to be in a table
+        bool lower(strview name, char *buf) throw()
+        {
+            if (name.size() > maxname)
+                return false;
+
+            for (size_t i = 0; i < name.size(); i++)
+                buf[i] = static_cast<char>(tolower(static_cast<unsigned char>(name[i])));
+
+            return true;
+        }
+
+        /**
+         * Name to id lookup table, built once from one of the static name lists above.
+         * Open addressing with linear probing, kept at most 1/4 full.
+         */
+        template <class E, class T>
+        class nametable
+        {
+        public:
+            template <size_t N>
+            nametable(const E (&entries)[N], T unknown) throw()
+                : mask(0), none(unknown)
+            {
+                size_t size = 16;
+
+                while (size < N * 4)
+                    size *= 2;
+
+                mask = size - 1;
+                slots.resize(size);
+
+                for (size_t i = 0; i < N; i++)
+                {
+                    hashvalue h = fasthash(entries[i].name, strlen(entries[i].name));
+                    size_t pos = static_cast<size_t>(h) & mask;
+
+                    while (slots[pos].entry)
+                        pos = (pos + 1) & mask;
+
+                    slots[pos].hash = h;
+                    slots[pos].entry = &entries[i];
+                }
+            }
+
+            T find(strview name) const throw()
+            {
+                char buf[maxname];
+
+                if (name.empty() || !lower(name, buf))
+                    return none;
+
+                strview key(buf, name.size());
+                hashvalue h = key.hash();
+
+                for (size_t pos = static_cast<size_t>(h) & mask; slots[pos].entry; pos = (pos + 1) & mask)
+                {
+                    if (slots[pos].hash == h && key == slots[pos].entry->name)
+                        return slots[pos].entry->id;
+                }
+
+                return none;
+            }
+
+        protected:
+            struct slot
+            {
+                hashvalue hash;
+                const E *entry;
+
+                slot() throw()
+                    : hash(0), entry(NULL)
+                {
+                    // empty
+                }
+            };
+
+            std::vector<slot> slots;
+            size_t mask;
+            T none;
+        };
+    }
+
+    tagid lookuptag(strview name) throw()
+    {
+        static const nametable<tagname, tagid> table(tagnames, TidyTag_UNKNOWN); // built on first lookup
+        return table.find(name);
+    }
+
+    attributeid lookupattribute(strview name) throw()
+    {
+        static const nametable<attrname, attributeid> table(attrnames, TidyAttr_UNKNOWN); // built on first lookup
+        return table.find(name);
+    }
+
+    TidyAttr findattribute(TidyNode n, strview name) throw()
+    {
+        if (!n || name.empty())
+            return NULL;
+
+        attributeid id = lookupattribute(name);
+
+        if (id != TidyAttr_UNKNOWN)
+            return tidyAttrGetById(n, id);
+
+        size_t len = name.size();
+
+        for (TidyAttr a = tidyAttrFirst(n); a; a = tidyAttrNext(a))
+        {
+            ctmbstr an = tidyAttrName(a);
+
+            // strnlen stops one byte past the wanted length, so longer names cost no more than shorter ones
+            if (an && strnlen(an, len + 1) == len && !strncasecmp(an, name.data(), len))
+                return a;
+        }
+
+        return NULL;
+    }
+}
@@ -20,6 +20,7 @@
 
 #include "../include/tidypp/node.hpp"
 #include "../include/tidypp/attribute.hpp"
+#include "../include/tidypp/names.hpp"
 
 namespace tidypp
 {
@@ -34,6 +35,12 @@ namespace tidypp
         data = other.data;
     }
 
+    node &node::operator=(const node &other) throw()
+    {
+        data = other.data;
+        return *this;
+    }
+
     node::~node() throw()
     {
         // empty
@@ -64,6 +71,21 @@ namespace tidypp
         return attribute(tidyAttrFirst(data));
     }
 
+    node::attribute_range node::attributes() throw()
+    {
+        return attribute_range(attribute_iterator(data ? tidyAttrFirst(data) : NULL), attribute_iterator());
+    }
+
+    node::child_range node::children() throw()
+    {
+        return child_range(child_iterator(data ? tidyGetChild(data) : NULL), child_iterator());
+    }
+
+    node::descendant_range node::descendants(order ord) throw()
+    {
+        return descendant_range(descendant_iterator(data, ord), descendant_iterator());
+    }
+
     nodetype node::type() throw()
     {
         return tidyNodeGetType(data);
@@ -74,11 +96,21 @@ namespace tidypp
         return tidyNodeGetName(data);
     }
 
+    strview node::nameview() throw()
+    {
+        return strview(tidyNodeGetName(data));
+    }
+
     attribute node::attrgetbyid(attributeid id) throw()
     {
         return attribute(tidyAttrGetById(data, id));
     }
 
+    attribute node::attr(strview name) throw()
+    {
+        return attribute(findattribute(data, name));
+    }
+
     bool node::istext() throw()
     {
         return tidyNodeIsText(data);
@@ -504,6 +536,150 @@ namespace tidypp
         return tidyNodeIsMENU(data);
     }
 
+    // node::child_iterator methods
+    node::child_iterator::child_iterator() throw()
+    {
+        // empty
+    }
+
+    node::child_iterator::child_iterator(const TidyNode &first) throw()
+        : cur(first)
+    {
+        // empty
+    }
+
+    node &node::child_iterator::operator*() const throw()
+    {
+        return cur;
+    }
+
+    node *node::child_iterator::operator->() const throw()
+    {
+        return &cur;
+    }
+
+    node::child_iterator &node::child_iterator::operator++() throw()
+    {
+        cur.data = tidyGetNext(cur.data);
+        return *this;
+    }
+
+    node::child_iterator node::child_iterator::operator++(int) throw()
+    {
+        child_iterator res(*this);
+        ++*this;
+        return res;
+    }
+
+    bool node::child_iterator::operator==(const child_iterator &other) const throw()
+    {
+        return cur.data == other.cur.data;
+    }
+
+    bool node::child_iterator::operator!=(const child_iterator &other) const throw()
+    {
+        return cur.data != other.cur.data;
+    }
+
+    // node::descendant_iterator methods
+    node::descendant_iterator::descendant_iterator() throw()
+        : root(NULL), ord(preorder)
+    {
+        // empty
+    }
+
+    node::descendant_iterator::descendant_iterator(const TidyNode &root, order ord) throw()
+        : root(root), ord(ord)
+    {
+        TidyNode first = root ? tidyGetChild(root) : NULL;
+
+        if (first && ord == postorder)
+            first = leftmostleaf(first);
+
+        cur.data = first;
+    }
+
+    node &node::descendant_iterator::operator*() const throw()
+    {
+        return cur;
+    }
+
+    node *node::descendant_iterator::operator->() const throw()
+    {
+        return &cur;
+    }
+
+    node::descendant_iterator &node::descendant_iterator::operator++() throw()
+    {
+        TidyNode n = cur.data;
+        TidyNode next;
+
+        if (!n)
+            return *this;
+
+        if (ord == preorder)
+        {
+            // go down if possible, otherwise to the next sibling of the closest ancestor that has one
+            next = tidyGetChild(n);
+
+            while (!next && n != root)
+            {
+                next = tidyGetNext(n);
+
+                if (!next)
+                {
+                    n = tidyGetParent(n);
+
+                    if (n == root)
+                        break;
+                }
+            }
+        }
+        else
+        {
+            // next sibling's deepest first child, or the parent once all its children are done
+            next = tidyGetNext(n);
+
+            if (next)
+                next = leftmostleaf(next);
+            else
+            {
+                next = tidyGetParent(n);
+
+                if (next == root)
+                    next = NULL;
+            }
+        }
+
+        cur.data = next;
+        return *this;
+    }
+
+    node::descendant_iterator node::descendant_iterator::operator++(int) throw()
+    {
+        descendant_iterator res(*this);
+        ++*this;
+        return res;
+    }
+
+    bool node::descendant_iterator::operator==(const descendant_iterator &other) const throw()
+    {
+        return cur.data == other.cur.data;
+    }
+
+    bool node::descendant_iterator::operator!=(const descendant_iterator &other) const throw()
+    {
+        return cur.data != other.cur.data;
+    }
+
+    TidyNode node::descendant_iterator::leftmostleaf(TidyNode n) throw()
+    {
+        for (TidyNode c = tidyGetChild(n); c; c = tidyGetChild(n))
+            n = c;
+
+        return n;
+    }
+
     node::node(const TidyNode &data) throw()
         : basic_wrapper<TidyNode>(data)
     {
@@ -19,9 +19,117 @@
 */
 
 #include "../include/tidypp/option.hpp"
+#include <ctype.h>
+#include <string.h>
+#include <strings.h>
+#include <vector>
 
 namespace tidypp
 {
+    namespace
+    {
+        /**
+         * Name to id lookup table for Tidy options, built once from Tidy's own option list.
+         * Open addressing with linear probing, kept at most 1/4 full so that a lookup is almost always a single
+         * hash and a single string compare instead of tidyOptGetIdForName's linear scan.
+         * Names are case-insensitive, as in Tidy.
+         */
+        class optiontable
+        {
+        public:
+            optiontable() throw()
+                : mask(0)
+            {
+                TidyDoc doc = tidyCreate();
+                std::vector<TidyOption> opts;
+                size_t size = 16;
+
+                for (TidyIterator it = tidyGetOptionList(doc); it; )
+                {
+                    TidyOption opt = tidyGetNextOption(doc, &it);
+
+                    if (opt && tidyOptGetName(opt))
+                        opts.push_back(opt);
+                }
+
+                while (size < opts.size() * 4)
+                    size *= 2;
+
+                mask = size - 1;
+                slots.resize(size);
+
+                for (size_t i = 0; i < opts.size(); i++)
+                {
+                    ctmbstr name = tidyOptGetName(opts[i]);
+                    hashvalue h = hash(name);
+                    size_t pos = static_cast<size_t>(h) & mask;
+
+                    while (slots[pos].name)
+                        pos = (pos + 1) & mask;
+
+                    slots[pos].hash = h;
+                    slots[pos].name = name; // points into Tidy's static option table, valid after release
+                    slots[pos].id = tidyOptGetId(opts[i]);
+                }
+
+                tidyRelease(doc);
+            }
+
+            optionid find(ctmbstr name) const throw()
+            {
+                if (!name || slots.empty())
+                    return N_TIDY_OPTIONS;
+
+                hashvalue h = hash(name);
+
+                for (size_t pos = static_cast<size_t>(h) & mask; slots[pos].name; pos = (pos + 1) & mask)
+                {
+                    if (slots[pos].hash == h && !strcasecmp(slots[pos].name, name))
+                        return slots[pos].id;
+                }
+
+                return N_TIDY_OPTIONS;
+            }
+
+            static const optiontable &get() throw()
+            {
+                static optiontable table; // built on first lookup
+                return table;
+            }
+
+        protected:
+            struct slot
+            {
+                hashvalue hash;
+                ctmbstr name;
+                optionid id;
+
+                slot() throw()
+                    : hash(0), name(NULL), id(N_TIDY_OPTIONS)
+                {
+                    // empty
+                }
+            };
+
+            std::vector<slot> slots;
+            size_t mask;
+
+            // hash of the lowercase name
+            static hashvalue hash(ctmbstr name) throw()
+            {
+                hashvalue h = hashseed;
+
+                for (; *name; name++)
+                {
+                    char c = static_cast<char>(tolower(static_cast<unsigned char>(*name)));
+                    h = hashbytes(&c, 1, h);
+                }
+
+                return h;
+            }
+        };
+    }
+
     // option methods
     option::option() throw()
     {
@@ -90,7 +198,7 @@ namespace tidypp
 
     optionid option::getidbyname(ctmbstr name) throw()
     {
-        return tidyOptGetIdForName(name);
+        return optiontable::get().find(name);
     }
 
     option::option(const TidyOption &data) throw()
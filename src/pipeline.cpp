@@ -0,0 +1,499 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#include "../include/tidypp/pipeline.hpp"
+#include "../include/tidypp/document.hpp"
+#include "../include/tidypp/buffer.hpp"
+#include "../include/tidypp/inputsource.hpp"
+#include "../include/tidypp/outputsink.hpp"
+#include "../include/tidypp/ringqueue.hpp"
+#include "internal.hpp"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace tidypp
+{
+    using internal::clock;
+    using internal::elapsed;
+    using internal::readfile;
+    using internal::readsource;
+    using internal::tolerant;
+
+    namespace
+    {
+        size_t hardwarehalf()
+        {
+            size_t n = std::thread::hardware_concurrency() / 2;
+            return n ? n : 1;
+        }
+    }
+
+    // pipeline::slot
+    struct pipeline::slot
+    {
+        mem::pool pool; /**< Declared first, everything below allocates from it. Used by one stage at a time. */
+        document doc;
+        buffer in; /**< Attached to the input while parsing. */
+        buffer out;
+        buffer errors; /**< Receives Tidy's report, cleared for each item. */
+        std::vector<byte> data; /**< The input, unless it's a memory item. */
+        size_t index; /**< Item in flight. */
+        bool failed; /**< A stage failed, the following ones only pass the slot on. */
+        bool parsed; /**< The input reached Tidy. */
+        clock::time_point start;
+
+        slot() throw()
+            : doc(pool), out(pool), errors(pool), index(0), failed(false), parsed(false)
+        {
+            // empty
+        }
+    };
+
+    // pipeline::ring
+    class pipeline::ring : public ringqueue<slot *>
+    {
+    public:
+        ring(size_t capacity)
+            : ringqueue<slot *>(capacity), producers(0), isclosed(false)
+        {
+            // empty
+        }
+
+        // producers register before the threads start, the last one to finish closes the queue
+        void addproducer() throw()
+        {
+            producers.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void done() throw()
+        {
+            if (producers.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                isclosed.store(true, std::memory_order_release);
+        }
+
+        bool closed() const throw()
+        {
+            return isclosed.load(std::memory_order_acquire);
+        }
+
+    private:
+        std::atomic<size_t> producers;
+        std::atomic<bool> isclosed;
+    };
+
+    // pipeline::summary methods
+    pipeline::summary::summary() throw()
+        : items(0), failed(0), bytesin(0), bytesout(0), seconds(0), threads(0), inflight(0)
+    {
+        for (size_t i = 0; i < stagecount; i++)
+            busy[i] = 0;
+    }
+
+    double pipeline::summary::throughput() const throw()
+    {
+        return seconds > 0 ? bytesin / seconds : 0;
+    }
+
+    // pipeline::config methods
+    pipeline::config::config() throw()
+        : readers(1), parsers(0), cleaners(0), writers(1), inflight(0), clean(true), diagnostics(false),
+          output(batch::output_save)
+    {
+        // empty
+    }
+
+    // pipeline methods
+    pipeline::pipeline(const config &cfg)
+        : cfg(cfg), next(0)
+    {
+        // empty
+    }
+
+    pipeline::~pipeline() throw()
+    {
+        for (size_t i = 0; i < slots.size(); i++)
+            delete slots[i];
+    }
+
+    void pipeline::add(const item &it)
+    {
+        items.push_back(it);
+    }
+
+    size_t pipeline::size() const throw()
+    {
+        return items.size();
+    }
+
+    void pipeline::clear() throw()
+    {
+        items.clear();
+        res.clear();
+    }
+
+    const pipeline::summary &pipeline::run() throw(const exception &)
+    {
+        size_t counts[stagecount] =
+        {
+            cfg.readers ? cfg.readers : 1,
+            cfg.parsers ? cfg.parsers : hardwarehalf(),
+            cfg.cleaners ? cfg.cleaners : hardwarehalf(),
+            cfg.writers ? cfg.writers : 1
+        };
+
+        size_t threads = counts[stage_read] + counts[stage_parse] + counts[stage_clean] + counts[stage_save];
+        size_t inflight = cfg.inflight ? cfg.inflight : 2 * threads;
+
+        // no point in more documents than items
+        inflight = std::min(inflight, std::max<size_t>(items.size(), 1));
+
+        // slots are created on this thread so that configuration errors are thrown to the caller
+        while (slots.size() < inflight)
+            slots.push_back(makeslot());
+
+        // every queue can hold every slot, so pushes never wait: backpressure comes from the free slots
+        ring free(inflight), toparse(inflight), toclean(inflight), tosave(inflight);
+        ring *queues[stagecount + 1] = { &free, &toparse, &toclean, &tosave, &free };
+        std::vector<double> busy(threads, 0);
+        std::vector<std::thread> pool;
+
+        for (size_t i = 0; i < inflight; i++)
+        {
+            slot *s = slots[i];
+            free.trypush(std::move(s));
+        }
+
+        for (size_t st = 0; st < stagecount; st++)
+        {
+            for (size_t i = 0; i < counts[st]; i++)
+                queues[st + 1]->addproducer();
+        }
+
+        clock::time_point start = clock::now();
+
+        res.assign(items.size(), result());
+        next.store(0, std::memory_order_relaxed);
+
+        for (size_t st = 0, k = 0; st < stagecount; st++)
+        {
+            for (size_t i = 0; i < counts[st]; i++, k++)
+            {
+                if (st == stage_read)
+                    pool.push_back(std::thread(&pipeline::readmain, this, std::ref(free), std::ref(toparse),
+                                               std::ref(busy[k])));
+                else
+                    pool.push_back(std::thread(&pipeline::stagemain, this, static_cast<stage>(st),
+                                               std::ref(*queues[st]), std::ref(*queues[st + 1]),
+                                               std::ref(busy[k])));
+            }
+        }
+
+        for (size_t i = 0; i < pool.size(); i++)
+            pool[i].join();
+
+        sum = summary();
+        sum.items = items.size();
+        sum.threads = threads;
+        sum.inflight = inflight;
+        sum.seconds = elapsed(start);
+
+        for (size_t st = 0, k = 0; st < stagecount; st++)
+        {
+            for (size_t i = 0; i < counts[st]; i++, k++)
+                sum.busy[st] += busy[k];
+        }
+
+        for (size_t i = 0; i < res.size(); i++)
+        {
+            sum.failed += !res[i].ok;
+            sum.bytesin += res[i].bytesin;
+            sum.bytesout += res[i].bytesout;
+        }
+
+        return sum;
+    }
+
+    const std::vector<pipeline::result> &pipeline::results() const throw()
+    {
+        return res;
+    }
+
+    const pipeline::summary &pipeline::totals() const throw()
+    {
+        return sum;
+    }
+
+    void pipeline::readmain(ring &in, ring &out, double &busy) throw()
+    {
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < items.size(); )
+        {
+            slot *s = NULL;
+
+            in.pop(s); // wait for a document to be released by the save stage
+
+            clock::time_point start = clock::now();
+
+            s->index = i;
+            s->start = start;
+            read(*s);
+            busy += elapsed(start);
+
+            out.push(std::move(s));
+        }
+
+        out.done();
+    }
+
+    void pipeline::stagemain(stage st, ring &in, ring &out, double &busy) throw()
+    {
+        unsigned spins = 0;
+
+        for (;;)
+        {
+            slot *s = NULL;
+
+            // once the queue is closed, everything that will ever be pushed is already there
+            bool closed = in.closed();
+
+            if (!in.trypop(s))
+            {
+                if (closed)
+                    break;
+
+                ring::backoff(spins);
+                continue;
+            }
+
+            spins = 0;
+
+            clock::time_point start = clock::now();
+
+            if (st == stage_parse)
+                parse(*s);
+            else if (st == stage_clean)
+                clean(*s);
+            else
+                save(*s);
+
+            busy += elapsed(start);
+
+            out.push(std::move(s));
+        }
+
+        out.done();
+    }
+
+    void pipeline::read(slot &s) throw()
+    {
+        const item &it = items[s.index];
+        result &r = res[s.index];
+
+        s.failed = false;
+        s.parsed = false;
+        s.errors.clear();
+
+        try
+        {
+            if (cfg.read)
+                cfg.read(s.index, it, s.data);
+            else if (!it.path.empty())
+            {
+                if (!readfile(it.path, s.data))
+                    throw exception("pipeline: failed to read " + it.path + ".");
+            }
+            else if (it.data)
+                return; // parsed in place
+            else if (it.source)
+            {
+                // drained here, so that the source does its I/O on the read stage
+                readsource(*it.source, s.data);
+            }
+            else
+                throw exception("pipeline: empty item.");
+
+            r.bytesin = s.data.size();
+        }
+        catch (const std::exception &e)
+        {
+            fail(s, e.what());
+        }
+        catch (...)
+        {
+            fail(s, "pipeline: unknown exception.");
+        }
+    }
+
+    void pipeline::parse(slot &s) throw()
+    {
+        if (s.failed)
+            return;
+
+        const item &it = items[s.index];
+        result &r = res[s.index];
+        static byte empty = 0;
+        byte *data = &empty;
+        size_t size;
+
+        if (it.data && !cfg.read)
+        {
+            size = it.size;
+
+            if (size)
+                data = static_cast<byte *>(const_cast<void *>(it.data));
+        }
+        else
+        {
+            size = s.data.size();
+
+            if (size)
+                data = &s.data[0];
+        }
+
+        r.bytesin = size;
+        s.in.attach(data, static_cast<uint>(size));
+        s.parsed = true;
+
+        try
+        {
+            tolerant(s.doc, [&] { s.doc.parsebuffer(s.in); });
+        }
+        catch (const std::exception &e)
+        {
+            fail(s, e.what());
+        }
+        catch (...)
+        {
+            fail(s, "pipeline: unknown exception.");
+        }
+
+        s.in.detach();
+    }
+
+    void pipeline::clean(slot &s) throw()
+    {
+        if (s.failed)
+            return;
+
+        try
+        {
+            if (cfg.clean)
+                tolerant(s.doc, [&] { s.doc.cleanandrepair(); });
+
+            if (cfg.diagnostics)
+                tolerant(s.doc, [&] { s.doc.rundiagnostics(); });
+        }
+        catch (const std::exception &e)
+        {
+            fail(s, e.what());
+        }
+        catch (...)
+        {
+            fail(s, "pipeline: unknown exception.");
+        }
+    }
+
+    void pipeline::save(slot &s) throw()
+    {
+        result &r = res[s.index];
+
+        try
+        {
+            if (!s.failed)
+            {
+                if (cfg.output == batch::output_save)
+                {
+                    // without force-output Tidy saves nothing for a document with errors
+                    if (s.doc.status() == 2 && !s.doc.optgetbool(TidyForceOutput))
+                        throw exception("pipeline: the document has errors and force-output is not set.");
+
+                    if (cfg.sink)
+                        tolerant(s.doc, [&] { s.doc.savesink(cfg.sink(s.index)); });
+                    else
+                    {
+                        s.out.clear();
+                        tolerant(s.doc, [&] { s.doc.savebuffer(s.out); });
+                        r.output.assign(reinterpret_cast<const char *>(s.out.ptr()), s.out.size());
+                    }
+                }
+                else if (cfg.output == batch::output_text)
+                    s.doc.extract_text(r.output);
+
+                r.ok = true;
+
+                if (cfg.process)
+                    cfg.process(s.index, s.doc, r);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            fail(s, e.what());
+        }
+        catch (...)
+        {
+            fail(s, "pipeline: unknown exception.");
+        }
+
+        if (s.parsed)
+        {
+            r.status = s.doc.status();
+            r.errors = s.doc.errorcount();
+            r.warnings = s.doc.warningcount();
+        }
+
+        r.bytesout = r.output.size();
+        r.seconds = elapsed(s.start);
+    }
+
+    void pipeline::fail(slot &s, const char *message) throw()
+    {
+        result &r = res[s.index];
+
+        s.failed = true;
+        r.ok = false;
+        r.message = message;
+    }
+
+    pipeline::slot *pipeline::makeslot() throw(const exception &)
+    {
+        slot *s = new slot;
+
+        try
+        {
+            s->doc.seterrorbuffer(s->errors);
+
+            if (!cfg.configfile.empty())
+                s->doc.loadconfig(cfg.configfile.c_str());
+
+            for (size_t i = 0; i < cfg.options.size(); i++)
+                s->doc.optparsevalue(cfg.options[i].first.c_str(), cfg.options[i].second.c_str());
+
+            if (cfg.setup)
+                cfg.setup(s->doc);
+        }
+        catch (...)
+        {
+            delete s;
+            throw;
+        }
+
+        return s;
+    }
+}
@@ -0,0 +1,189 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#include "../include/tidypp/queryset.hpp"
+#include <ctype.h>
+#include <algorithm>
+
+namespace tidypp
+{
+    // queryset methods
+    queryset::queryset() throw()
+    {
+        // empty
+    }
+
+    queryset::~queryset() throw()
+    {
+        // empty
+    }
+
+    size_t queryset::add(ctmbstr text) throw(const exception &)
+    {
+        return add(selector(text));
+    }
+
+    size_t queryset::add(const selector &sel)
+    {
+        size_t query = queries.size();
+
+        queries.push_back(sel);
+
+        for (size_t i = 0; i < sel.chains.size(); i++)
+        {
+            rule r = { query, i };
+            const selector::compound &right = sel.chains[i][0];
+            const std::string *id = NULL;
+            const std::string *cls = NULL;
+
+            for (size_t j = 0; j < right.attrs.size(); j++)
+            {
+                const selector::attrtest &t = right.attrs[j];
+
+                if (t.id == TidyAttr_ID && t.op == '=')
+                    id = &t.value;
+                else if (t.id == TidyAttr_CLASS && t.op == '~' && !t.value.empty())
+                    cls = &t.value;
+            }
+
+            if (id)
+                byid[*id].push_back(r);
+            else if (cls)
+                byclass[*cls].push_back(r);
+            else if (right.tag != TidyTag_UNKNOWN && right.tag < N_TIDY_TAGS)
+                bytag[right.tag].push_back(r);
+            else
+                anytag.push_back(r);
+        }
+
+        return query;
+    }
+
+    size_t queryset::size() const throw()
+    {
+        return queries.size();
+    }
+
+    const selector &queryset::get(size_t query) const throw()
+    {
+        return queries[query];
+    }
+
+    void queryset::run(node &n, std::vector<match> &dst) const
+    {
+        std::vector<rule> rules; // reused for every element
+        selector::failset failed; // shared by the whole walk, see selector::select()
+
+        for (node &d : n.descendants())
+        {
+            TidyNode raw = d.data;
+            nodetype type = tidyNodeGetType(raw);
+
+            if (type != TidyNode_Start && type != TidyNode_StartEnd)
+                continue;
+
+            size_t last = static_cast<size_t>(-1);
+
+            candidates(raw, rules);
+
+            for (size_t i = 0; i < rules.size(); i++)
+            {
+                const rule &r = rules[i];
+
+                if (r.query == last)
+                    continue;
+
+                const selector &sel = queries[r.query];
+
+                if (sel.matchchain(sel.chains[r.chain], 0, raw, &failed))
+                {
+                    match m = { r.query, d };
+
+                    dst.push_back(m);
+                    last = r.query;
+                }
+            }
+        }
+    }
+
+    bool queryset::byquery(const rule &a, const rule &b) throw()
+    {
+        return a.query < b.query || (a.query == b.query && a.chain < b.chain);
+    }
+
+    void queryset::candidates(TidyNode n, std::vector<rule> &dst) const
+    {
+        tagid tag = tidyNodeGetId(n);
+        const rulelist &tagged = bytag[tag < N_TIDY_TAGS ? tag : TidyTag_UNKNOWN];
+        size_t lists = 0;
+
+        dst.clear();
+        dst.insert(dst.end(), tagged.begin(), tagged.end());
+        dst.insert(dst.end(), anytag.begin(), anytag.end());
+        lists += !tagged.empty() + !anytag.empty();
+
+        if (!byid.empty())
+        {
+            TidyAttr attr = tidyAttrGetById(n, TidyAttr_ID);
+            ctmbstr val = attr ? tidyAttrValue(attr) : NULL;
+            auto it = val ? byid.find(val) : byid.end();
+
+            if (it != byid.end())
+            {
+                dst.insert(dst.end(), it->second.begin(), it->second.end());
+                lists++;
+            }
+        }
+
+        if (!byclass.empty())
+        {
+            TidyAttr attr = tidyAttrGetById(n, TidyAttr_CLASS);
+            ctmbstr p = attr ? tidyAttrValue(attr) : NULL;
+            std::string word;
+
+            while (p && *p)
+            {
+                while (*p && isspace(static_cast<unsigned char>(*p)))
+                    p++;
+
+                ctmbstr start = p;
+
+                while (*p && !isspace(static_cast<unsigned char>(*p)))
+                    p++;
+
+                if (p == start)
+                    break;
+
+                word.assign(start, p);
+                auto it = byclass.find(word);
+
+                if (it != byclass.end())
+                {
+                    dst.insert(dst.end(), it->second.begin(), it->second.end());
+                    lists++;
+                }
+            }
+        }
+
+        // each list is sorted already, only merging several needs a sort so that matches come out by query id
+        if (lists > 1)
+            std::sort(dst.begin(), dst.end(), byquery);
+    }
+}
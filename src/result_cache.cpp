@@ -0,0 +1,292 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#include "../include/tidypp/result_cache.hpp"
+#include "../include/tidypp/document.hpp"
+#include "../include/tidypp/buffer.hpp"
+#include "../include/tidypp/disk_cache.hpp"
+#include "internal.hpp"
+
+namespace tidypp
+{
+    using internal::tolerant;
+
+    // result_cache::key methods
+    bool result_cache::key::operator==(const key &other) const throw()
+    {
+        return content == other.content && config == other.config && size == other.size;
+    }
+
+    // result_cache::result methods
+    result_cache::result::result() throw()
+        : status(0), errors(0), warnings(0), accesswarnings(0)
+    {
+        // empty
+    }
+
+    // result_cache::keyhash methods
+    size_t result_cache::keyhash::operator()(const key &k) const throw()
+    {
+        return static_cast<size_t>(k.content ^ (k.config * 0x9e3779b97f4a7c15ULL));
+    }
+
+    // result_cache::shard methods
+    result_cache::shard::shard() throw()
+        : bytes(0), hits(0), misses(0)
+    {
+        // empty
+    }
+
+    // result_cache methods
+    result_cache::result_cache(size_t capacity, size_t shards)
+        : cap(capacity), disk(NULL)
+    {
+        size_t n = 1;
+
+        while (n < shards)
+            n *= 2;
+
+        shardcap = capacity / n;
+        this->shards.resize(n);
+
+        for (size_t i = 0; i < n; i++)
+            this->shards[i] = new shard;
+    }
+
+    result_cache::~result_cache() throw()
+    {
+        for (size_t i = 0; i < shards.size(); i++)
+            delete shards[i];
+    }
+
+    result_cache::key result_cache::makekey(document &doc, const void *data, size_t size) throw()
+    {
+        key k;
+
+        k.content = fasthash(data, size);
+        k.config = doc.config_fingerprint();
+        k.size = size;
+
+        return k;
+    }
+
+    bool result_cache::find(const key &k, result &res)
+    {
+        shard &s = getshard(k);
+        std::lock_guard<std::mutex> guard(s.lock);
+
+        auto it = s.index.find(k);
+
+        if (it == s.index.end())
+        {
+            s.misses++;
+            return false;
+        }
+
+        s.hits++;
+        s.lru.splice(s.lru.begin(), s.lru, it->second); // move to front, iterators stay valid
+        res = it->second->res;
+
+        return true;
+    }
+
+    void result_cache::insert(const key &k, const result &res)
+    {
+        shard &s = getshard(k);
+        entry e;
+
+        e.k = k;
+        e.res = res;
+
+        size_t size = cost(e);
+
+        if (size > shardcap)
+            return;
+
+        std::lock_guard<std::mutex> guard(s.lock);
+
+        auto it = s.index.find(k);
+
+        if (it != s.index.end())
+        {
+            s.bytes -= cost(*it->second);
+            s.lru.erase(it->second);
+            s.index.erase(it);
+        }
+
+        while (!s.lru.empty() && s.bytes + size > shardcap)
+        {
+            s.bytes -= cost(s.lru.back());
+            s.index.erase(s.lru.back().k);
+            s.lru.pop_back();
+        }
+
+        s.lru.push_front(e);
+        s.index[k] = s.lru.begin();
+        s.bytes += size;
+    }
+
+    bool result_cache::process(document &doc, buffer &input, buffer &buf, result *info) throw(const exception &)
+    {
+        key k = makekey(doc, input.ptr(), input.size());
+        result res;
+        bool hit = find(k, res);
+
+        if (!hit && disk && disk->find(k, res))
+        {
+            insert(k, res); // promote to memory
+            hit = true;
+        }
+
+        if (hit)
+        {
+            if (!res.output.empty())
+                buf.append(const_cast<char *>(res.output.data()), res.output.size());
+
+            if (info)
+                *info = res;
+
+            return true;
+        }
+
+        uint start = buf.size();
+
+        // errors in the markup are part of the result, not a failure of process()
+        tolerant(doc, [&] { doc.parsebuffer(input); });
+        tolerant(doc, [&] { doc.cleanandrepair(); });
+
+        // without force-output Tidy saves nothing for a document with errors
+        if (doc.status() == 2 && !doc.optgetbool(TidyForceOutput))
+            throw exception("result_cache: the document has errors and force-output is not set.");
+
+        tolerant(doc, [&] { doc.savebuffer(buf); });
+        res.status = doc.status();
+
+        res.output.assign(reinterpret_cast<const char *>(buf.ptr()) + start, buf.size() - start);
+        res.errors = doc.errorcount();
+        res.warnings = doc.warningcount();
+        res.accesswarnings = doc.accesswarningcount();
+
+        insert(k, res);
+
+        if (disk)
+        {
+            try
+            {
+                disk->insert(k, res);
+            }
+            catch (const exception &)
+            {
+                // a full or failing disk only costs the second tier a result
+            }
+        }
+
+        if (info)
+            *info = res;
+
+        return false;
+    }
+
+    void result_cache::setdiskcache(disk_cache *disk) throw()
+    {
+        this->disk = disk;
+    }
+
+    void result_cache::clear()
+    {
+        for (size_t i = 0; i < shards.size(); i++)
+        {
+            std::lock_guard<std::mutex> guard(shards[i]->lock);
+
+            shards[i]->lru.clear();
+            shards[i]->index.clear();
+            shards[i]->bytes = 0;
+        }
+    }
+
+    uint64_t result_cache::hits()
+    {
+        uint64_t res = 0;
+
+        for (size_t i = 0; i < shards.size(); i++)
+        {
+            std::lock_guard<std::mutex> guard(shards[i]->lock);
+            res += shards[i]->hits;
+        }
+
+        return res;
+    }
+
+    uint64_t result_cache::misses()
+    {
+        uint64_t res = 0;
+
+        for (size_t i = 0; i < shards.size(); i++)
+        {
+            std::lock_guard<std::mutex> guard(shards[i]->lock);
+            res += shards[i]->misses;
+        }
+
+        return res;
+    }
+
+    size_t result_cache::count()
+    {
+        size_t res = 0;
+
+        for (size_t i = 0; i < shards.size(); i++)
+        {
+            std::lock_guard<std::mutex> guard(shards[i]->lock);
+            res += shards[i]->index.size();
+        }
+
+        return res;
+    }
+
+    size_t result_cache::bytes()
+    {
+        size_t res = 0;
+
+        for (size_t i = 0; i < shards.size(); i++)
+        {
+            std::lock_guard<std::mutex> guard(shards[i]->lock);
+            res += shards[i]->bytes;
+        }
+
+        return res;
+    }
+
+    size_t result_cache::capacity() throw()
+    {
+        return cap;
+    }
+
+    result_cache::shard &result_cache::getshard(const key &k) throw()
+    {
+        // the low bits feed the hash map buckets, use the high ones to pick the shard
+        return *shards[static_cast<size_t>(k.content >> 40) & (shards.size() - 1)];
+    }
+
+    size_t result_cache::cost(const entry &e) throw()
+    {
+        // output plus a rough estimate of the list node and hash map node overhead
+        return e.res.output.size() + sizeof(entry) + 4 * sizeof(void *);
+    }
+}
@@ -0,0 +1,463 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#include "../include/tidypp/selector.hpp"
+#include "../include/tidypp/names.hpp"
+#include <ctype.h>
+#include <string.h>
+#include <strings.h>
+
+namespace tidypp
+{
+    namespace
+    {
+        enum
+        {
+            firstchild = 1,
+            lastchild = 2
+        };
+
+        bool isident(char c)
+        {
+            return isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' || (c & 0x80);
+        }
+
+        bool iselement(TidyNode n)
+        {
+            nodetype type = tidyNodeGetType(n);
+            return type == TidyNode_Start || type == TidyNode_StartEnd;
+        }
+
+        TidyNode prevelement(TidyNode n)
+        {
+            for (n = tidyGetPrev(n); n && !iselement(n); n = tidyGetPrev(n));
+            return n;
+        }
+
+        TidyNode nextelement(TidyNode n)
+        {
+            for (n = tidyGetNext(n); n && !iselement(n); n = tidyGetNext(n));
+            return n;
+        }
+
+        TidyNode parentelement(TidyNode n)
+        {
+            n = tidyGetParent(n);
+            return n && iselement(n) ? n : NULL;
+        }
+
+        // does the whitespace separated list contain word?
+        bool hasword(ctmbstr list, const std::string &word)
+        {
+            size_t len = word.size();
+
+            for (ctmbstr p = list; *p; )
+            {
+                while (*p && isspace(static_cast<unsigned char>(*p)))
+                    p++;
+
+                ctmbstr start = p;
+
+                while (*p && !isspace(static_cast<unsigned char>(*p)))
+                    p++;
+
+                if (static_cast<size_t>(p - start) == len && !memcmp(start, word.data(), len))
+                    return true;
+            }
+
+            return false;
+        }
+
+        /**
+         * Minimal cursor over the selector text.
+         */
+        class cursor
+        {
+        public:
+            cursor(ctmbstr text) throw()
+                : p(text)
+            {
+                // empty
+            }
+
+            ctmbstr p;
+
+            bool skipspace() throw()
+            {
+                ctmbstr start = p;
+
+                while (*p && isspace(static_cast<unsigned char>(*p)))
+                    p++;
+
+                return p != start;
+            }
+
+            std::string ident(bool lower) throw(const exception &)
+            {
+                ctmbstr start = p;
+                std::string res;
+
+                while (isident(*p))
+                    p++;
+
+                if (p == start)
+                    throw exception(std::string("selector: expected a name at \"") + start + "\".");
+
+                res.assign(start, p);
+
+                if (lower)
+                {
+                    for (size_t i = 0; i < res.size(); i++)
+                        res[i] = static_cast<char>(tolower(static_cast<unsigned char>(res[i])));
+                }
+
+                return res;
+            }
+
+            std::string value() throw(const exception &)
+            {
+                if (*p != '"' && *p != '\'')
+                    return ident(false);
+
+                char quote = *p++;
+                ctmbstr start = p;
+
+                while (*p && *p != quote)
+                    p++;
+
+                if (!*p)
+                    throw exception("selector: unterminated string.");
+
+                return std::string(start, p++);
+            }
+        };
+    }
+
+    // selector::stephash methods
+    size_t selector::stephash::operator()(const step &s) const throw()
+    {
+        return std::hash<TidyNode>()(s.first) ^ (std::hash<const compound *>()(s.second) * 31);
+    }
+
+    // selector methods
+    selector::selector(ctmbstr text) throw(const exception &)
+        : src(text ? text : "")
+    {
+        parse(src.c_str());
+    }
+
+    selector::~selector() throw()
+    {
+        // empty
+    }
+
+    bool selector::matches(node &n) const throw()
+    {
+        return matches(n.data, NULL);
+    }
+
+    void selector::select(node &n, std::vector<node> &dst) const
+    {
+        failset failed; // shared by the whole walk, a step fails the same way whichever node led to it
+
+        for (node &d : n.descendants())
+        {
+            if (matches(d.data, &failed))
+                dst.push_back(d);
+        }
+    }
+
+    const std::string &selector::text() const throw()
+    {
+        return src;
+    }
+
+    bool selector::matches(TidyNode n, failset *failed) const throw()
+    {
+        if (!n || !iselement(n))
+            return false;
+
+        for (size_t i = 0; i < chains.size(); i++)
+        {
+            if (matchchain(chains[i], 0, n, failed))
+                return true;
+        }
+
+        return false;
+    }
+
+    void selector::parse(ctmbstr text) throw(const exception &)
+    {
+        cursor c(text);
+        chain ch;
+        char comb = 0;
+
+        c.skipspace();
+
+        if (!*c.p)
+            throw exception("selector: empty selector.");
+
+        for (;;)
+        {
+            compound cmp;
+            bool any = false;
+
+            cmp.tag = TidyTag_UNKNOWN;
+            cmp.pseudo = 0;
+            cmp.comb = comb;
+
+            if (*c.p == '*')
+            {
+                c.p++;
+                any = true;
+            }
+            else if (isident(*c.p))
+            {
+                cmp.name = c.ident(true);
+                cmp.tag = lookuptag(cmp.name);
+                any = true;
+            }
+
+            for (;;)
+            {
+                attrtest t;
+
+                if (*c.p == '#' || *c.p == '.')
+                {
+                    bool id = *c.p++ == '#';
+
+                    t.id = id ? TidyAttr_ID : TidyAttr_CLASS;
+                    t.name = id ? "id" : "class";
+                    t.op = id ? '=' : '~';
+                    t.value = c.ident(false);
+                    cmp.attrs.push_back(t);
+                }
+                else if (*c.p == '[')
+                {
+                    c.p++;
+                    c.skipspace();
+                    t.name = c.ident(true);
+                    t.id = lookupattribute(t.name);
+                    t.op = 0;
+                    c.skipspace();
+
+                    if (*c.p == '=')
+                        t.op = *c.p++;
+                    else if (strchr("~|^$*", *c.p) && *c.p && c.p[1] == '=')
+                    {
+                        t.op = *c.p;
+                        c.p += 2;
+                    }
+
+                    if (t.op)
+                    {
+                        c.skipspace();
+                        t.value = c.value();
+                        c.skipspace();
+                    }
+
+                    if (*c.p++ != ']')
+                        throw exception("selector: expected ']' in attribute selector.");
+
+                    cmp.attrs.push_back(t);
+                }
+                else if (*c.p == ':')
+                {
+                    c.p++;
+                    std::string pseudo = c.ident(true);
+
+                    if (pseudo == "first-child")
+                        cmp.pseudo |= firstchild;
+                    else if (pseudo == "last-child")
+                        cmp.pseudo |= lastchild;
+                    else if (pseudo == "only-child")
+                        cmp.pseudo |= firstchild | lastchild;
+                    else
+                        throw exception("selector: unsupported pseudo-class :" + pseudo + ".");
+                }
+                else
+                    break;
+
+                any = true;
+            }
+
+            if (!any)
+                throw exception(std::string("selector: unexpected \"") + c.p + "\".");
+
+            ch.push_back(cmp);
+
+            bool space = c.skipspace();
+
+            if (!*c.p || *c.p == ',')
+            {
+                // chains are matched right to left. Each compound keeps the combinator on its left, which is
+                // the one that links it to the next compound of the reversed chain
+                chains.push_back(chain(ch.rbegin(), ch.rend()));
+                ch.clear();
+                comb = 0;
+
+                if (!*c.p)
+                    break;
+
+                c.p++;
+                c.skipspace();
+                continue;
+            }
+
+            if (*c.p == '>' || *c.p == '+' || *c.p == '~')
+            {
+                comb = *c.p++;
+                c.skipspace();
+            }
+            else if (space)
+                comb = ' ';
+            else
+                throw exception(std::string("selector: unexpected \"") + c.p + "\".");
+        }
+    }
+
+    bool selector::matchchain(const chain &c, size_t k, TidyNode n, failset *failed) const throw()
+    {
+        if (!matchcompound(c[k], n))
+            return false;
+
+        if (k + 1 == c.size())
+            return true;
+
+        // remember the steps that walk ancestors or siblings, they are the costly ones to repeat; the subject
+        // (k == 0) is only tried once per node, so remembering it would never pay off
+        bool memo = failed && k && (c[k].comb == ' ' || c[k].comb == '~');
+
+        if (memo && failed->count(step(n, &c[k])))
+            return false;
+
+        TidyNode m;
+        bool res = false;
+
+        switch (c[k].comb)
+        {
+        case '>':
+            m = parentelement(n);
+            return m && matchchain(c, k + 1, m, failed);
+
+        case ' ':
+            for (m = parentelement(n); m && !res; m = parentelement(m))
+                res = matchchain(c, k + 1, m, failed);
+
+            break;
+
+        case '+':
+            m = prevelement(n);
+            return m && matchchain(c, k + 1, m, failed);
+
+        case '~':
+            for (m = prevelement(n); m && !res; m = prevelement(m))
+                res = matchchain(c, k + 1, m, failed);
+
+            break;
+        }
+
+        if (memo && !res)
+        {
+            try
+            {
+                failed->insert(step(n, &c[k]));
+            }
+            catch (...)
+            {
+                // only a cache
+            }
+        }
+
+        return res;
+    }
+
+    bool selector::matchcompound(const compound &c, TidyNode n) throw()
+    {
+        if (c.tag != TidyTag_UNKNOWN)
+        {
+            if (tidyNodeGetId(n) != c.tag)
+                return false;
+        }
+        else if (!c.name.empty())
+        {
+            ctmbstr name = tidyNodeGetName(n);
+
+            if (!name || strcasecmp(name, c.name.c_str()))
+                return false;
+        }
+
+        for (size_t i = 0; i < c.attrs.size(); i++)
+        {
+            if (!matchattr(c.attrs[i], n))
+                return false;
+        }
+
+        if ((c.pseudo & firstchild) && prevelement(n))
+            return false;
+
+        if ((c.pseudo & lastchild) && nextelement(n))
+            return false;
+
+        return true;
+    }
+
+    bool selector::matchattr(const attrtest &t, TidyNode n) throw()
+    {
+        // the id was resolved when the selector was compiled, only unknown names need a scan
+        TidyAttr attr = t.id != TidyAttr_UNKNOWN ? tidyAttrGetById(n, t.id) : findattribute(n, strview(t.name));
+
+        if (!attr)
+            return false;
+
+        if (!t.op)
+            return true;
+
+        ctmbstr val = tidyAttrValue(attr);
+        size_t vlen = val ? strlen(val) : 0;
+        size_t tlen = t.value.size();
+
+        if (!val)
+            val = "";
+
+        switch (t.op)
+        {
+        case '=':
+            return vlen == tlen && !memcmp(val, t.value.data(), tlen);
+
+        case '~':
+            return hasword(val, t.value);
+
+        case '|':
+            return vlen >= tlen && !memcmp(val, t.value.data(), tlen) && (vlen == tlen || val[tlen] == '-');
+
+        case '^':
+            return tlen && vlen >= tlen && !memcmp(val, t.value.data(), tlen);
+
+        case '$':
+            return tlen && vlen >= tlen && !memcmp(val + vlen - tlen, t.value.data(), tlen);
+
+        case '*':
+            return tlen && strstr(val, t.value.c_str());
+        }
+
+        return false;
+    }
+}
@@ -0,0 +1,126 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#include "../include/tidypp/sourcemap.hpp"
+#include "../include/tidypp/buffer.hpp"
+#include "../include/tidypp/node.hpp"
+
+namespace tidypp
+{
+    // sourcemap methods
+    const size_t sourcemap::npos;
+
+    sourcemap::sourcemap(const void *data, size_t size, uint tabsize, bool utf8)
+        : p(static_cast<const char *>(data)), len(size), tabs(tabsize), utf8(utf8)
+    {
+        build();
+    }
+
+    sourcemap::sourcemap(buffer &buf, uint tabsize, bool utf8)
+        : p(reinterpret_cast<const char *>(buf.ptr())), len(buf.size()), tabs(tabsize), utf8(utf8)
+    {
+        build();
+    }
+
+    sourcemap::~sourcemap() throw()
+    {
+        // empty
+    }
+
+    strview sourcemap::input() const throw()
+    {
+        return strview(p, len);
+    }
+
+    size_t sourcemap::linecount() const throw()
+    {
+        return lines.size();
+    }
+
+    size_t sourcemap::offset(uint line, uint column) const throw()
+    {
+        if (!line || !column || line > lines.size())
+            return npos;
+
+        size_t i = lines[line - 1];
+        size_t end = line < lines.size() ? lines[line] : len;
+        uint col = 1;
+
+        while (col < column && i < end)
+        {
+            if (p[i] == '\t' && tabs)
+                col += tabs - (col - 1) % tabs;
+            else
+                col++;
+
+            i++;
+
+            if (utf8)
+            {
+                while (i < end && (static_cast<unsigned char>(p[i]) & 0xc0) == 0x80)
+                    i++;
+            }
+        }
+
+        return col == column ? i : npos;
+    }
+
+    strview sourcemap::source(node &n) const throw()
+    {
+        size_t start = n.valid() ? offset(n.line(), n.column()) : npos;
+
+        if (start == npos)
+            return strview();
+
+        for (node cur = n; cur.valid(); cur = cur.parent())
+        {
+            node next = cur.next();
+
+            if (!next.valid())
+                continue;
+
+            size_t end = offset(next.line(), next.column());
+
+            return end != npos && end >= start ? strview(p + start, end - start) : strview();
+        }
+
+        return strview(p + start, len - start);
+    }
+
+    void sourcemap::build()
+    {
+        lines.clear();
+        lines.push_back(0);
+
+        // Tidy ends lines on \n, \r\n and a lone \r
+        for (size_t i = 0; i < len; i++)
+        {
+            if (p[i] == '\r')
+            {
+                if (i + 1 < len && p[i + 1] == '\n')
+                    i++;
+            }
+            else if (p[i] != '\n')
+                continue;
+
+            lines.push_back(i + 1);
+        }
+    }
+}
@@ -22,12 +22,119 @@
 
 namespace tidypp
 {
+    namespace
+    {
+        const hashvalue prime1 = 11400714785074694791ULL;
+        const hashvalue prime2 = 14029467366897019727ULL;
+        const hashvalue prime3 = 1609587929392839161ULL;
+        const hashvalue prime4 = 9650029242287828579ULL;
+        const hashvalue prime5 = 2870177450012600261ULL;
+
+        inline hashvalue rotl(hashvalue x, int r)
+        {
+            return (x << r) | (x >> (64 - r));
+        }
+
+        // little endian loads, compiled to a single mov on x86
+        inline hashvalue load64(const byte *p)
+        {
+            return static_cast<hashvalue>(p[0]) | static_cast<hashvalue>(p[1]) << 8 |
+                static_cast<hashvalue>(p[2]) << 16 | static_cast<hashvalue>(p[3]) << 24 |
+                static_cast<hashvalue>(p[4]) << 32 | static_cast<hashvalue>(p[5]) << 40 |
+                static_cast<hashvalue>(p[6]) << 48 | static_cast<hashvalue>(p[7]) << 56;
+        }
+
+        inline hashvalue load32(const byte *p)
+        {
+            return static_cast<hashvalue>(p[0]) | static_cast<hashvalue>(p[1]) << 8 |
+                static_cast<hashvalue>(p[2]) << 16 | static_cast<hashvalue>(p[3]) << 24;
+        }
+
+        inline hashvalue hashround(hashvalue acc, hashvalue input)
+        {
+            return rotl(acc + input * prime2, 31) * prime1;
+        }
+
+        inline hashvalue hashmerge(hashvalue acc, hashvalue val)
+        {
+            return (acc ^ hashround(0, val)) * prime1 + prime4;
+        }
+    }
+
     // functions
     ctmbstr releasedate() throw()
     {
         return tidyReleaseDate();
     }
 
+    hashvalue hashbytes(const void *data, size_t size, hashvalue seed) throw()
+    {
+        const byte *p = static_cast<const byte *>(data);
+        hashvalue res = seed;
+
+        for (size_t i = 0; i < size; i++)
+        {
+            res ^= p[i];
+            res *= 1099511628211ULL; // 64-bit FNV prime
+        }
+
+        return res;
+    }
+
+    hashvalue fasthash(const void *data, size_t size, hashvalue seed) throw()
+    {
+        const byte *p = static_cast<const byte *>(data);
+        const byte *end = p + size;
+        hashvalue h;
+
+        if (size >= 32)
+        {
+            hashvalue v1 = seed + prime1 + prime2;
+            hashvalue v2 = seed + prime2;
+            hashvalue v3 = seed;
+            hashvalue v4 = seed - prime1;
+
+            // four independent lanes so the multiplies can overlap
+            for (; p + 32 <= end; p += 32)
+            {
+                v1 = hashround(v1, load64(p));
+                v2 = hashround(v2, load64(p + 8));
+                v3 = hashround(v3, load64(p + 16));
+                v4 = hashround(v4, load64(p + 24));
+            }
+
+            h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+            h = hashmerge(h, v1);
+            h = hashmerge(h, v2);
+            h = hashmerge(h, v3);
+            h = hashmerge(h, v4);
+        }
+        else
+            h = seed + prime5;
+
+        h += size;
+
+        for (; p + 8 <= end; p += 8)
+            h = rotl(h ^ hashround(0, load64(p)), 27) * prime1 + prime4;
+
+        if (p + 4 <= end)
+        {
+            h = rotl(h ^ (load32(p) * prime1), 23) * prime2 + prime3;
+            p += 4;
+        }
+
+        for (; p < end; p++)
+            h = rotl(h ^ (*p * prime5), 11) * prime1;
+
+        h ^= h >> 33;
+        h *= prime2;
+        h ^= h >> 29;
+        h *= prime3;
+        h ^= h >> 32;
+
+        return h;
+    }
+
     // exception methods
     exception::exception(std::string info) throw()
     {
@@ -43,4 +150,28 @@ namespace tidypp
     {
         return info.c_str();
     }
+
+    // timeout methods
+    timeout::timeout(std::string info) throw()
+        : exception(info)
+    {
+        // empty
+    }
+
+    timeout::~timeout() throw()
+    {
+        // empty
+    }
+
+    // limitexceeded methods
+    limitexceeded::limitexceeded(std::string info) throw()
+        : exception(info)
+    {
+        // empty
+    }
+
+    limitexceeded::~limitexceeded() throw()
+    {
+        // empty
+    }
 }
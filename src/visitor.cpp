@@ -0,0 +1,124 @@
+/*
+    tidypp - a c++ wrapper around HTML Tidy Lib
+    Copyright (C) 2012  Francesco "Franc[e]sco" Noferi (francesco1149@gmail.com)
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public
+    License along with this library; if not, write to the
+    Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+    Boston, MA  02110-1301, USA.
+*/
+
+#include "../include/tidypp/visitor.hpp"
+#include "../include/tidypp/names.hpp"
+
+namespace tidypp
+{
+    // visitor::attrlist::iterator methods
+    visitor::attrlist::iterator::iterator(TidyAttr first) throw()
+        : cur(first)
+    {
+        // empty
+    }
+
+    visitor::attr visitor::attrlist::iterator::operator*() const throw()
+    {
+        attr res;
+
+        res.id = tidyAttrGetId(cur);
+        res.name = strview(tidyAttrName(cur));
+        res.value = strview(tidyAttrValue(cur));
+
+        return res;
+    }
+
+    visitor::attrlist::iterator &visitor::attrlist::iterator::operator++() throw()
+    {
+        cur = tidyAttrNext(cur);
+        return *this;
+    }
+
+    bool visitor::attrlist::iterator::operator==(const iterator &other) const throw()
+    {
+        return cur == other.cur;
+    }
+
+    bool visitor::attrlist::iterator::operator!=(const iterator &other) const throw()
+    {
+        return cur != other.cur;
+    }
+
+    // visitor::attrlist methods
+    visitor::attrlist::attrlist(TidyNode n) throw()
+        : n(n)
+    {
+        // empty
+    }
+
+    visitor::attrlist::iterator visitor::attrlist::begin() const throw()
+    {
+        return iterator(tidyAttrFirst(n));
+    }
+
+    visitor::attrlist::iterator visitor::attrlist::end() const throw()
+    {
+        return iterator(NULL);
+    }
+
+    bool visitor::attrlist::empty() const throw()
+    {
+        return !tidyAttrFirst(n);
+    }
+
+    bool visitor::attrlist::has(attributeid id) const throw()
+    {
+        return tidyAttrGetById(n, id) != NULL;
+    }
+
+    strview visitor::attrlist::get(attributeid id) const throw()
+    {
+        TidyAttr a = tidyAttrGetById(n, id);
+        return a ? strview(tidyAttrValue(a)) : strview();
+    }
+
+    strview visitor::attrlist::get(strview name) const throw()
+    {
+        TidyAttr a = findattribute(n, name);
+        return a ? strview(tidyAttrValue(a)) : strview();
+    }
+
+    // visitor methods
+    visitor::~visitor() throw()
+    {
+        // empty
+    }
+
+    bool visitor::on_start(tagid, strview, const attrlist &)
+    {
+        return true;
+    }
+
+    void visitor::on_end(tagid, strview)
+    {
+        // empty
+    }
+
+    void visitor::on_text(strview)
+    {
+        // empty
+    }
+
+    void visitor::on_comment(strview)
+    {
+        // empty
+    }
+}